@@ -3,7 +3,9 @@
 #include "Request.h"
 #include "StatusReport.h"
 
+#include <algorithm>
 #include <list>
+#include <utility>
 
 namespace ramulator {
 
@@ -12,7 +14,22 @@ struct BaseLLC {
   unsigned int assoc;
   unsigned int block_size;
   unsigned int num_mshr_entries;
-  std::list<Request> retry_list;
+  // requests the cache below rejected, with the cycle they were blocked,
+  // in arrival order
+  std::list<std::pair<long, Request>> retry_list;
+
+  // bumped every time an MSHR entry frees, which also unlocks its line,
+  // or the cache's writeback buffer stops being full; a rejected request
+  // can't go through before this changes
+  long releases = 0;
+
+  // coreid of the MSHR entry released last. Secondary misses of other cores
+  // merge into an entry, so this can differ from the core of the response.
+  int released_coreid = 0;
+
+  // false for levels that only hold the victims of the levels above them
+  // (exclusive hierarchies): misses get an MSHR entry but no line
+  bool fill_on_miss = true;
 
   BaseLLC(int size, int assoc, int block_size, int num_mshr_entries)
       : size(size),
@@ -24,6 +41,39 @@ struct BaseLLC {
 
   virtual void callback(Request& req) {}
 
+  // would send handle a request for addr now, without changing any state
+  virtual bool can_accept(long addr) { return true; }
+
+  // is the block cached or being filled, so a request for it can't evict
+  virtual bool holds(long addr) { return false; }
+
+  // drop the block if it is cached and not being filled, setting dirty to
+  // whether it was
+  virtual bool invalidate(long addr, bool& dirty) { return false; }
+
+  // put a block evicted from the level above into the cache, unlocked.
+  // Lines it evicts are recorded in report; if the set is full of lines
+  // being filled the block itself is passed on as evicted.
+  virtual void install(long addr,
+                       bool dirty,
+                       int coreid,
+                       StatusReport& report) {}
+
+  // the block being filled is dirty, no-op if it isn't being filled
+  virtual void mark_dirty(long addr) {}
+
+  // fill addr for coreid like a read miss, unless it is cached or being
+  // filled already. Prefetches leave prefetch_reserve() MSHR entries to
+  // demands and set mshr_unavailable or set_unavailable in report when
+  // they are dropped for lack of room.
+  virtual bool prefetch(long addr, int coreid, StatusReport& report) {
+    return false;
+  }
+
+  unsigned int prefetch_reserve() const {
+    return std::max(1u, num_mshr_entries / 4);
+  }
+
   virtual ~BaseLLC() {}
 };
 }
\ No newline at end of file
@@ -19,14 +19,37 @@ Cache::Cache(int size,
              int mshr_entry_num,
              Level level,
              std::shared_ptr<CacheSystem> cachesys)
-    : level(level), cachesys(cachesys), higher_cache(0), lower_cache(nullptr) {
+    : level(level),
+      cachesys(cachesys),
+      higher_cache(0),
+      lower_cache(nullptr),
+      writeback_buffer(cachesys->writeback_entries, block_size) {
+
+  if (level == Level::L1) {
+    level_string = "L1";
+  } else if (level == Level::L2) {
+    level_string = "L2";
+  } else if (level == Level::L3) {
+    level_string = "L3";
+  }
 
   if (cachesys->cache_qos == CacheSystem::Cache_QoS::basic) {
     llc = std::make_shared<SimpleLLC>(size, assoc, block_size, mshr_entry_num);
   } else if (cachesys->cache_qos == CacheSystem::Cache_QoS::way_partitioning) {
-    llc = std::make_shared<WaypartLLC>(size, assoc, block_size, mshr_entry_num);
+    llc = std::make_shared<WaypartLLC>(size,
+                                       assoc,
+                                       block_size,
+                                       mshr_entry_num,
+                                       cachesys->core_num,
+                                       cachesys->waypart_epoch,
+                                       level_string);
   } else if (cachesys->cache_qos == CacheSystem::Cache_QoS::custom) {
-    llc = std::make_shared<CustomLLC>(size, assoc, block_size, mshr_entry_num);
+    llc = std::make_shared<CustomLLC>(size,
+                                      assoc,
+                                      block_size,
+                                      mshr_entry_num,
+                                      cachesys->custom_policy,
+                                      level_string);
   } else {
     std::terminate();
   }
@@ -37,17 +60,24 @@ Cache::Cache(int size,
         llc->assoc,
         llc->block_size);
 
-  if (level == Level::L1) {
-    level_string = "L1";
-  } else if (level == Level::L2) {
-    level_string = "L2";
-  } else if (level == Level::L3) {
-    level_string = "L3";
-  }
-
   is_first_level = (level == cachesys->first_level);
   is_last_level = (level == cachesys->last_level);
 
+  if (cachesys->inclusion == CacheSystem::Inclusion::exclusive &&
+      !is_first_level) {
+    llc->fill_on_miss = false;
+  }
+
+  if (writeback_buffer.enabled()) {
+    cachesys->writeback_caches.push_back(this);
+  }
+
+  const std::string& prefetcher_type = cachesys->prefetchers[int(level)];
+  if (prefetcher_type != "" && prefetcher_type != "none") {
+    prefetcher = Prefetcher::create(
+        prefetcher_type, block_size, cachesys->prefetch_degree);
+  }
+
   // regStats
   cache_read_miss.name(level_string + string("_cache_read_miss"))
       .desc("cache read miss count")
@@ -86,6 +116,123 @@ Cache::Cache(int size,
   cache_set_unavailable.name(level_string + string("_cache_set_unavailable"))
       .desc("cache set not available")
       .precision(0);
+  cache_back_invalidations.name(level_string +
+                                string("_cache_back_invalidations"))
+      .desc("lines invalidated above because this level evicted them")
+      .precision(0);
+  cache_victim_fills.name(level_string + string("_cache_victim_fills"))
+      .desc("lines evicted from the level above installed in this one")
+      .precision(0);
+  cache_prefetches.name(level_string + string("_cache_prefetches"))
+      .desc("prefetches issued")
+      .precision(0);
+  cache_prefetch_dropped.name(level_string + string("_cache_prefetch_dropped"))
+      .desc("prefetches dropped for lack of MSHR entries or lines")
+      .precision(0);
+  cache_prefetch_useful.name(level_string + string("_cache_prefetch_useful"))
+      .desc("prefetched lines hit by a demand")
+      .precision(0);
+  cache_prefetch_late.name(level_string + string("_cache_prefetch_late"))
+      .desc("demands that found their prefetch still being filled")
+      .precision(0);
+  cache_prefetch_useless.name(level_string + string("_cache_prefetch_useless"))
+      .desc("prefetched lines evicted without a demand hit")
+      .precision(0);
+  cache_writebacks.name(level_string + string("_cache_writebacks"))
+      .desc("writebacks sent to memory from the writeback buffer")
+      .precision(0);
+  cache_writeback_coalesced.name(level_string +
+                                 string("_cache_writeback_coalesced"))
+      .desc("writebacks of blocks already in the writeback buffer")
+      .precision(0);
+  cache_writeback_forwards.name(level_string +
+                                string("_cache_writeback_forwards"))
+      .desc("read misses served from the writeback buffer")
+      .precision(0);
+  cache_writeback_stalls.name(level_string + string("_cache_writeback_stalls"))
+      .desc("requests rejected while the writeback buffer was full")
+      .precision(0);
+  cache_writeback_overflows.name(level_string +
+                                 string("_cache_writeback_overflows"))
+      .desc("writebacks sent straight to memory, the buffer being full")
+      .precision(0);
+  cache_writeback_occupancy.name(level_string +
+                                 string("_cache_writeback_occupancy"))
+      .desc("writeback buffer entries summed over cycles")
+      .precision(0);
+  cache_writeback_max_occupancy.name(level_string +
+                                     string("_cache_writeback_max_occupancy"))
+      .desc("most writeback buffer entries used")
+      .precision(0);
+  cache_retries.name(level_string + string("_cache_retries"))
+      .desc("requests sent to the lower cache after it rejected them")
+      .precision(0);
+  cache_retry_wait_cycles.name(level_string +
+                               string("_cache_retry_wait_cycles"))
+      .desc("cycles requests waited for the lower cache to accept them")
+      .precision(0);
+
+  // per-core copies of the stats above
+  auto per_core = [&](VectorStat& stat, const string& name,
+                      const string& desc) {
+    stat.init(cachesys->core_num)
+        .name(level_string + string("_cache_") + name + string("_core"))
+        .desc(desc + string(" per core"))
+        .precision(0);
+  };
+  per_core(cache_read_access_core, "read_access", "cache read access count");
+  per_core(cache_write_access_core, "write_access", "cache write access count");
+  per_core(cache_total_access_core, "total_access", "cache total access count");
+  per_core(cache_read_miss_core, "read_miss", "cache read miss count");
+  per_core(cache_write_miss_core, "write_miss", "cache write miss count");
+  per_core(cache_total_miss_core, "total_miss", "cache total miss count");
+  per_core(cache_eviction_core,
+           "eviction",
+           "number of evict from this level to lower level");
+  per_core(cache_mshr_hit_core, "mshr_hit", "cache mshr hit count");
+  per_core(cache_mshr_unavailable_core,
+           "mshr_unavailable",
+           "cache mshr not available count");
+  per_core(cache_set_unavailable_core,
+           "set_unavailable",
+           "cache set not available");
+  per_core(cache_back_invalidations_core,
+           "back_invalidations",
+           "lines invalidated above because this level evicted them");
+  per_core(cache_victim_fills_core,
+           "victim_fills",
+           "lines evicted from the level above installed in this one");
+  per_core(cache_prefetches_core, "prefetches", "prefetches issued");
+  per_core(cache_prefetch_dropped_core,
+           "prefetch_dropped",
+           "prefetches dropped for lack of MSHR entries or lines");
+  per_core(cache_prefetch_useful_core,
+           "prefetch_useful",
+           "prefetched lines hit by a demand");
+  per_core(cache_prefetch_late_core,
+           "prefetch_late",
+           "demands that found their prefetch still being filled");
+  per_core(cache_prefetch_useless_core,
+           "prefetch_useless",
+           "prefetched lines evicted without a demand hit");
+  per_core(cache_retries_core,
+           "retries",
+           "requests sent to the lower cache after it rejected them");
+  per_core(cache_retry_wait_cycles_core,
+           "retry_wait_cycles",
+           "cycles requests waited for the lower cache to accept them");
+  per_core(cache_writeback_forwards_core,
+           "writeback_forwards",
+           "read misses served from the writeback buffer");
+  per_core(cache_writeback_stalls_core,
+           "writeback_stalls",
+           "requests rejected while the writeback buffer was full");
+  per_core(cache_mshr_occupancy_core,
+           "mshr_occupancy",
+           "MSHR entries held times cycles, up to the last change,");
+
+  mshr_held.assign(cachesys->core_num, 0);
+  mshr_held_since.assign(cachesys->core_num, 0);
 }
 
 bool Cache::send(Request req) {
@@ -96,12 +243,24 @@ bool Cache::send(Request req) {
         get_index(req.addr),
         get_tag(req.addr));
 
+  int core = get_core(req);
+
+  // a request that could evict a dirty block waits for the buffer
+  if (writeback_buffer.full() && !llc->holds(req.addr)) {
+    cache_writeback_stalls++;
+    cache_writeback_stalls_core[core]++;
+    return false;
+  }
+
   cache_total_access++;
+  cache_total_access_core[core]++;
   if (req.type == Request::Type::WRITE) {
     cache_write_access++;
+    cache_write_access_core[core]++;
   } else {
     assert(req.type == Request::Type::READ);
     cache_read_access++;
+    cache_read_access_core[core]++;
   }
 
   StatusReport report;
@@ -112,6 +271,13 @@ bool Cache::send(Request req) {
                            cache_mshr_hit,
                            cache_mshr_unavailable,
                            cache_set_unavailable);
+  report.update_core_send_stats(core,
+                                cache_total_miss_core,
+                                cache_write_miss_core,
+                                cache_read_miss_core,
+                                cache_mshr_hit_core,
+                                cache_mshr_unavailable_core,
+                                cache_set_unavailable_core);
 
   // basic correctness checks
 
@@ -120,11 +286,17 @@ bool Cache::send(Request req) {
   }
 
   if (report.hit) {
-    cachesys->hit_list.push_back(
-        make_pair(cachesys->clk + latency[int(level)], req));
+    cachesys->hit_list.push(cachesys->clk + latency[int(level)], req);
 
     debug("hit, update timestamp %ld", cachesys->clk);
     debug("hit finish time %ld", cachesys->clk + latency[int(level)]);
+
+    // the block moves up to the cache that missed on it
+    bool dirty = false;
+    if (cachesys->inclusion == CacheSystem::Inclusion::exclusive &&
+        !is_first_level && llc->invalidate(req.addr, dirty) && dirty) {
+      pass_dirty(req.addr);
+    }
   }
 
   if (report.mshr_hit) {
@@ -135,23 +307,115 @@ bool Cache::send(Request req) {
     debug("no mshr entry available");
   }
 
+  if (report.prefetch_useful) {
+    cache_prefetch_useful++;
+    cache_prefetch_useful_core[core]++;
+  }
+
+  if (report.prefetch_late) {
+    cache_prefetch_late++;
+    cache_prefetch_late_core[core]++;
+  }
+
+  if (report.mshr_allocated) {
+    update_mshr_occupancy(core, 1);
+  }
+
   if (report.mshr_allocated) {
     if (!is_last_level) {
       if (!lower_cache->send(req)) {
-        llc->retry_list.push_back(req);
+        llc->retry_list.push_back(make_pair(cachesys->clk, req));
       }
     } else {
-      cachesys->wait_list.push_back(
-          make_pair(cachesys->clk + latency[int(level)], req));
+      read_memory(req, core);
     }
   }
 
+  handle_evictions(report, core);
+
+  // train on the handled demands, not on prefetches from the level above
+  if (prefetcher && handled && !is_prefetch(req)) {
+    prefetch_candidates.clear();
+    prefetcher->access(req.addr,
+                       req.coreid,
+                       !report.hit,
+                       prefetch_candidates);
+    for (long addr : prefetch_candidates) {
+      issue_prefetch(addr, req);
+    }
+  }
+
+  return handled;
+}
+
+void Cache::issue_prefetch(long addr, const Request& trigger) {
+  int core = get_core(trigger);
+
+  // a prefetch the lower cache would reject is dropped, not retried
+  if ((!is_last_level && !lower_cache->can_accept(addr)) ||
+      writeback_buffer.full()) {
+    cache_prefetch_dropped++;
+    cache_prefetch_dropped_core[core]++;
+    return;
+  }
+
+  StatusReport report;
+  if (!llc->prefetch(addr, trigger.coreid, report)) {
+    if (report.mshr_unavailable || report.set_unavailable) {
+      cache_prefetch_dropped++;
+      cache_prefetch_dropped_core[core]++;
+    }
+    return;
+  }
+  cache_prefetches++;
+  cache_prefetches_core[core]++;
+  update_mshr_occupancy(core, 1);
+
+  Request req(addr,
+              Request::Type::READ,
+              PrefetchCallback{trigger.callback},
+              trigger.coreid);
+  if (!is_last_level) {
+    if (!lower_cache->send(req)) {
+      llc->retry_list.push_back(make_pair(cachesys->clk, req));
+    }
+  } else {
+    read_memory(req, core);
+  }
+
+  handle_evictions(report, core);
+}
+
+void Cache::handle_evictions(StatusReport& report, int core) {
   cache_eviction += report.evictions;
+  cache_eviction_core[core] += report.evictions;
+  cache_prefetch_useless += report.prefetch_useless;
+  cache_prefetch_useless_core[core] += report.prefetch_useless;
+
+  if (cachesys->inclusion == CacheSystem::Inclusion::inclusive &&
+      !is_first_level) {
+    for (auto& evicted : report.evicted) {
+      back_invalidate(evicted.addr, core);
+    }
+  }
+
+  if (cachesys->inclusion == CacheSystem::Inclusion::exclusive &&
+      !is_last_level) {
+    // victims, dirty or not, fill the lower cache instead of memory
+    for (auto& evicted : report.evicted) {
+      StatusReport lower_report;
+      lower_cache->llc->install(
+          evicted.addr, evicted.dirty, evicted.coreid, lower_report);
+      lower_cache->cache_victim_fills++;
+      lower_cache->cache_victim_fills_core[core]++;
+      lower_cache->handle_evictions(lower_report, core);
+    }
+    return;
+  }
 
   // fire requests to memory
   for (auto& write_req : report.requests) {
-    cachesys->wait_list.push_back(
-        make_pair(cachesys->clk + latency[int(level)], write_req));
+    write_back(write_req);
 
     debug(
         "inject one write request to memory system "
@@ -160,8 +424,28 @@ bool Cache::send(Request req) {
         0,
         cachesys->clk + latency[int(level)]);
   }
+}
+
+void Cache::back_invalidate(long addr, int core) {
+  for (auto hc : higher_cache) {
+    // lines still being filled are left alone
+    bool dirty = false;
+    if (hc->llc->invalidate(addr, dirty)) {
+      cache_back_invalidations++;
+      cache_back_invalidations_core[core]++;
+      if (dirty) {
+        write_back(Request(addr, Request::Type::WRITE));
+      }
+    }
+    hc->back_invalidate(addr, core);
+  }
+}
 
-  return handled;
+void Cache::pass_dirty(long addr) {
+  for (auto hc : higher_cache) {
+    hc->llc->mark_dirty(addr);
+    hc->pass_dirty(addr);
+  }
 }
 
 void Cache::concatlower(Cache* lower) {
@@ -173,7 +457,11 @@ void Cache::concatlower(Cache* lower) {
 void Cache::callback(Request& req) {
   debug("level %d", int(level));
 
+  long releases = llc->releases;
   llc->callback(req);
+  if (llc->releases != releases) {
+    update_mshr_occupancy(get_core(llc->released_coreid), -1);
+  }
 
   if (higher_cache.size()) {
     for (auto hc : higher_cache) {
@@ -186,42 +474,136 @@ void Cache::tick() {
 
   if (!lower_cache->is_last_level) lower_cache->tick();
 
-  for (auto it = llc->retry_list.begin(); it != llc->retry_list.end(); it++) {
-    if (lower_cache->send(*it)) it = llc->retry_list.erase(it);
+  // The lower cache only rejects requests while its MSHR or their set is
+  // full, so nothing is retried until it has released an entry. Then the
+  // requests it can take are sent in arrival order.
+  if (llc->retry_list.empty() ||
+      lower_cache->llc->releases == retry_releases) {
+    return;
+  }
+  retry_releases = lower_cache->llc->releases;
+
+  auto it = llc->retry_list.begin();
+  while (it != llc->retry_list.end()) {
+    if (lower_cache->can_accept(it->second.addr) &&
+        lower_cache->send(it->second)) {
+      int core = get_core(it->second);
+      cache_retries++;
+      cache_retries_core[core]++;
+      cache_retry_wait_cycles += cachesys->clk - it->first;
+      cache_retry_wait_cycles_core[core] += cachesys->clk - it->first;
+      it = llc->retry_list.erase(it);
+    } else {
+      ++it;
+    }
   }
 }
 
-void CacheSystem::tick() {
-  debug("clk %ld", clk);
+bool Cache::can_accept(long addr) {
+  return llc->can_accept(addr) &&
+         (!writeback_buffer.full() || llc->holds(addr));
+}
 
-  ++clk;
+void Cache::write_back(const Request& req) {
+  long ready = cachesys->clk + latency[int(level)];
+  if (!writeback_buffer.enabled()) {
+    cachesys->wait_list.push(ready, req);
+  } else if (writeback_buffer.contains(req.addr)) {
+    cache_writeback_coalesced++;
+  } else if (!writeback_buffer.push(ready, req.addr)) {
+    // evictions that no request could be held back for, like victim fills
+    // from the level above
+    cache_writeback_overflows++;
+    cachesys->wait_list.push(ready, req);
+  }
+}
 
-  // Sends ready waiting request to memory
-  auto it = wait_list.begin();
-  while (it != wait_list.end() && clk >= it->first) {
-    if (!send_memory(it->second)) {
-      ++it;
-    } else {
+void Cache::read_memory(const Request& req, int core) {
+  if (writeback_buffer.contains(req.addr)) {
+    // the dirty block is on chip, the writeback still goes to memory
+    cache_writeback_forwards++;
+    cache_writeback_forwards_core[core]++;
+    cachesys->hit_list.push(cachesys->clk + latency[int(level)], req);
+  } else {
+    cachesys->wait_list.push(cachesys->clk + latency[int(level)], req);
+  }
+}
 
-      debug("complete req: addr %lx", (it->second).addr);
+void Cache::drain_writebacks() {
+  size_t size = writeback_buffer.size();
+  cache_writeback_occupancy += size;
+  cache_writeback_max_occupancy = writeback_buffer.max_size;
 
-      it = wait_list.erase(it);
+  if (size >= cachesys->writeback_high_watermark * writeback_buffer.capacity) {
+    writeback_buffer.draining = true;
+  } else if (size <=
+             cachesys->writeback_low_watermark * writeback_buffer.capacity) {
+    writeback_buffer.draining = false;
+  }
+
+  // below the watermark writebacks only use cycles demands leave to them
+  int budget = writeback_buffer.draining
+                   ? writeback_buffer.capacity
+                   : (cachesys->memory_ready.empty() ? 1 : 0);
+  while (budget-- > 0 && writeback_buffer.ready(cachesys->clk)) {
+    Request req(writeback_buffer.front_addr(), Request::Type::WRITE);
+    if (!cachesys->send_memory(req)) {
+      break;
     }
+    if (writeback_buffer.full()) {
+      // requests held back for the buffer may go through now
+      llc->releases++;
+    }
+    writeback_buffer.pop();
+    cache_writebacks++;
   }
+}
 
-  // hit request callback
-  it = hit_list.begin();
-  while (it != hit_list.end()) {
-    if (clk >= it->first) {
-      it->second.callback(it->second);
+int Cache::get_core(const Request& req) {
+  return get_core(req.coreid);
+}
 
-      debug("finish hit: addr %lx", (it->second).addr);
+int Cache::get_core(int coreid) {
+  return (coreid >= 0 && coreid < cachesys->core_num) ? coreid : 0;
+}
 
-      it = hit_list.erase(it);
+void Cache::update_mshr_occupancy(int core, int delta) {
+  cache_mshr_occupancy_core[core] +=
+      long(mshr_held[core]) * (cachesys->clk - mshr_held_since[core]);
+  mshr_held[core] += delta;
+  mshr_held_since[core] = cachesys->clk;
+}
+
+void CacheSystem::tick() {
+  debug("clk %ld", clk);
+
+  ++clk;
+
+  // Sends ready waiting request to memory, the ones memory rejects are
+  // retried next cycle ahead of newer ones
+  wait_list.expire(clk, [this](Request& req) { memory_ready.push_back(req); });
+  auto kept = memory_ready.begin();
+  for (auto it = memory_ready.begin(); it != memory_ready.end(); ++it) {
+    if (!send_memory(*it)) {
+      if (kept != it) *kept = std::move(*it);
+      ++kept;
     } else {
-      ++it;
+
+      debug("complete req: addr %lx", it->addr);
     }
   }
+  memory_ready.erase(kept, memory_ready.end());
+
+  for (auto cache : writeback_caches) {
+    cache->drain_writebacks();
+  }
+
+  // hit request callback
+  hit_list.expire(clk, [](Request& req) {
+    req.callback(req);
+
+    debug("finish hit: addr %lx", req.addr);
+  });
 }
 
 }  // namespace ramulator
@@ -6,6 +6,9 @@
 #include "Request.h"
 #include "Statistics.h"
 #include "StatusReport.h"
+#include "Prefetcher.h"
+#include "TimingWheel.h"
+#include "WritebackBuffer.h"
 
 // LLCs
 #include "BaseLLC.h"
@@ -72,6 +75,57 @@ class Cache {
   // cache contention
   ScalarStat cache_set_unavailable;
 
+  // inclusion
+  ScalarStat cache_back_invalidations;
+  ScalarStat cache_victim_fills;
+
+  // prefetching
+  ScalarStat cache_prefetches;
+  ScalarStat cache_prefetch_dropped;
+  ScalarStat cache_prefetch_useful;
+  ScalarStat cache_prefetch_late;
+  ScalarStat cache_prefetch_useless;
+
+  // writeback buffer
+  ScalarStat cache_writebacks;
+  ScalarStat cache_writeback_coalesced;
+  ScalarStat cache_writeback_forwards;
+  ScalarStat cache_writeback_stalls;
+  ScalarStat cache_writeback_overflows;
+  ScalarStat cache_writeback_occupancy;
+  ScalarStat cache_writeback_max_occupancy;
+
+  // requests the lower cache rejected
+  ScalarStat cache_retries;
+  ScalarStat cache_retry_wait_cycles;
+
+  // the same per core, indexed by Request::coreid; with the instructions
+  // each core retired the misses give its MPKI
+  VectorStat cache_read_access_core;
+  VectorStat cache_write_access_core;
+  VectorStat cache_total_access_core;
+  VectorStat cache_read_miss_core;
+  VectorStat cache_write_miss_core;
+  VectorStat cache_total_miss_core;
+  VectorStat cache_eviction_core;
+  VectorStat cache_mshr_hit_core;
+  VectorStat cache_mshr_unavailable_core;
+  VectorStat cache_set_unavailable_core;
+  VectorStat cache_back_invalidations_core;
+  VectorStat cache_victim_fills_core;
+  VectorStat cache_prefetches_core;
+  VectorStat cache_prefetch_dropped_core;
+  VectorStat cache_prefetch_useful_core;
+  VectorStat cache_prefetch_late_core;
+  VectorStat cache_prefetch_useless_core;
+  VectorStat cache_retries_core;
+  VectorStat cache_retry_wait_cycles_core;
+  VectorStat cache_writeback_forwards_core;
+  VectorStat cache_writeback_stalls_core;
+
+  // MSHR entries held per core, integrated over cycles
+  VectorStat cache_mshr_occupancy_core;
+
   // ---------cache data members---------
   // which level (L1, L2, etc.) is this cache at?
   Level level;
@@ -86,9 +140,23 @@ class Cache {
   // non-LLC has a cache below it
   Cache* lower_cache;
 
+  // lower_cache->llc->releases when retry_list was last retried
+  long retry_releases = -1;
+
+  // MSHR entries held per core and the cycle that count last changed
+  std::vector<int> mshr_held;
+  std::vector<long> mshr_held_since;
+
   // LLC
   std::shared_ptr<BaseLLC> llc;
 
+  // dirty blocks on their way to memory
+  WritebackBuffer writeback_buffer;
+
+  // null when the level doesn't prefetch
+  std::unique_ptr<Prefetcher> prefetcher;
+  std::vector<long> prefetch_candidates;
+
   // L1, L2, L3 accumulated latencies
   // these are fixed in the simulation model
   int latency[int(Level::MAX)] = {4, 4 + 12, 4 + 12 + 31};
@@ -113,6 +181,43 @@ class Cache {
   void concatlower(Cache* lower);
 
   void callback(Request& req);
+
+  // apply the inclusion policy to the lines a request evicted and send
+  // the dirty ones to memory where they don't go to the lower cache
+  void handle_evictions(StatusReport& report, int core);
+
+  // invalidate the block in every cache above this one, writing dirty
+  // copies to memory
+  void back_invalidate(long addr, int core);
+
+  // the block was dirty below the caches above this one that are filling it
+  void pass_dirty(long addr);
+
+  // fill addr ahead of demand, on behalf of the demand request trigger
+  void issue_prefetch(long addr, const Request& trigger);
+
+  // would send take a request for addr now, without changing any state
+  bool can_accept(long addr);
+
+  // send a dirty block to memory through the writeback buffer
+  void write_back(const Request& req);
+
+  // send a read miss to memory, unless a pending writeback has the block
+  void read_memory(const Request& req, int core);
+
+  // send buffered writebacks to memory: one a cycle while no demand waits
+  // for memory, all that memory takes once the high watermark is crossed
+  // until the low one is reached
+  void drain_writebacks();
+
+  // the core a request is counted against; requests without one, such as
+  // writebacks, count against core 0
+  int get_core(const Request& req);
+
+  int get_core(int coreid);
+
+  // core allocated (delta 1) or released (delta -1) an MSHR entry
+  void update_mshr_occupancy(int core, int delta);
 };
 
 class CacheSystem {
@@ -143,8 +248,57 @@ class CacheSystem {
     } else {
       cache_qos = Cache_QoS::basic;
     }
+
+    core_num = configs.get_core_num();
+    if (configs["waypart_epoch"] != "") {
+      waypart_epoch = std::stol(configs["waypart_epoch"]);
+    }
+    if (configs["custom_policy"] != "") {
+      custom_policy = configs["custom_policy"];
+    }
+
+    // l1_prefetcher, l2_prefetcher and l3_prefetcher name the prefetcher
+    // of each level
+    const char* levels[] = {"l1", "l2", "l3"};
+    for (int i = 0; i < int(Cache::Level::MAX); i++) {
+      prefetchers.push_back(configs[string(levels[i]) + "_prefetcher"]);
+    }
+    if (configs["prefetch_degree"] != "") {
+      prefetch_degree = std::stoi(configs["prefetch_degree"]);
+    }
+
+    if (configs["writeback_buffer_entries"] != "") {
+      writeback_entries = std::stoi(configs["writeback_buffer_entries"]);
+    }
+    if (configs["writeback_high_watermark"] != "") {
+      writeback_high_watermark = std::stof(configs["writeback_high_watermark"]);
+    }
+    if (configs["writeback_low_watermark"] != "") {
+      writeback_low_watermark = std::stof(configs["writeback_low_watermark"]);
+    }
+
+    if (configs["inclusion"] == "inclusive") {
+      inclusion = Inclusion::inclusive;
+    } else if (configs["inclusion"] == "exclusive") {
+      inclusion = Inclusion::exclusive;
+    } else if (configs["inclusion"] != "" && configs["inclusion"] != "nine") {
+      fprintf(stderr, "unknown inclusion %s, expected nine, inclusive or "
+              "exclusive\n", configs["inclusion"].c_str());
+      std::terminate();
+    }
   }
 
+  // how the contents of a level relate to the levels above it
+  enum class Inclusion {
+    // neither inclusive nor exclusive, levels fill on misses and evict
+    // independently
+    nine,
+    // evictions from a level back-invalidate the levels above
+    inclusive,
+    // levels below the first only hold the victims of the levels above
+    exclusive
+  } inclusion = Inclusion::nine;
+
   // 18-740
   enum class Cache_QoS {
     basic,
@@ -152,15 +306,37 @@ class CacheSystem {
     custom
   } cache_qos;
 
-  // wait_list contains miss requests with their latencies in
-  // cache. When this latency is met, the send_memory function
-  // will be called to send the request to the memory system.
-  std::list<std::pair<long, Request>> wait_list;
+  int core_num;
+
+  // LLC accesses between two way_partitioning allocations
+  long waypart_epoch = 100000;
+
+  // custom LLC replacement: srrip, brrip or drrip
+  std::string custom_policy = "drrip";
+
+  // writeback buffer entries per cache (0 sends writebacks straight to
+  // memory) and the fractions of them that start and stop a full drain
+  int writeback_entries = 0;
+  float writeback_high_watermark = 0.75;
+  float writeback_low_watermark = 0.25;
+
+  // caches with a writeback buffer, drained every cycle
+  std::vector<Cache*> writeback_caches;
+
+  // prefetcher per level, empty or none for no prefetching
+  std::vector<std::string> prefetchers;
+  int prefetch_degree = 2;
+
+  // wait_list contains miss requests keyed by the cycle their latency in
+  // cache is met. Then they move to memory_ready and the send_memory
+  // function is called until the memory system accepts them.
+  TimingWheel<Request> wait_list;
+  std::vector<Request> memory_ready;
 
-  // hit_list contains hit requests with their latencies in cache.
-  // callback function will be called when this latency is met and
-  // set the instruction status to ready in processor's window.
-  std::list<std::pair<long, Request>> hit_list;
+  // hit_list contains hit requests keyed by the cycle their latency in
+  // cache is met. Then the callback function is called and sets the
+  // instruction status to ready in processor's window.
+  TimingWheel<Request> hit_list;
 
   std::function<bool(Request)> send_memory;
 
@@ -1,11 +1,389 @@
 #include "CustomLLC.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <exception>
+
 namespace ramulator {
 
-CustomLLC::CustomLLC(int size, int assoc, int block_size, int num_mshr_entries)
-    : BaseLLC(size, assoc, block_size, num_mshr_entries) {}
+// out-of-class definitions, std::min takes psel_max by reference and C++11
+// needs storage for it
+constexpr uint8_t CustomLLC::max_rrpv;
+constexpr int CustomLLC::brrip_long_interval;
+constexpr int CustomLLC::psel_max;
+
+CustomLLC::CustomLLC(int size,
+                     int assoc,
+                     int block_size,
+                     int num_mshr_entries,
+                     const std::string& policy,
+                     const std::string& level_string)
+    : BaseLLC(size, assoc, block_size, num_mshr_entries),
+      mshr(num_mshr_entries, block_size) {
+
+  // Check size, block size and assoc are 2^N
+  assert((size & (size - 1)) == 0);
+  assert((block_size & (block_size - 1)) == 0);
+  assert((assoc & (assoc - 1)) == 0);
+  assert(size >= block_size);
+  assert(assoc <= UINT16_MAX);
+
+  if (policy == "srrip") {
+    this->policy = Policy::SRRIP;
+  } else if (policy == "brrip") {
+    this->policy = Policy::BRRIP;
+  } else if (policy == "drrip") {
+    this->policy = Policy::DRRIP;
+  } else {
+    fprintf(stderr, "unknown custom LLC policy %s, expected srrip, brrip or "
+            "drrip\n", policy.c_str());
+    std::terminate();
+  }
+
+  block_num = size / (block_size * assoc);
+  index_mask = block_num - 1;
+  index_offset = calc_log2(block_size);
+  tag_offset = calc_log2(block_num) + index_offset;
+
+  lines.assign(size_t(block_num) * assoc,
+               Line{0, 0, max_rrpv, false, false, false, false});
+  set_size.assign(block_num, 0);
+
+  // 32 leaders of each policy, or every set a leader in small caches
+  leader_stride = std::max(2u, block_num / 32);
+
+  srrip_inserts.name(level_string + "_cache_srrip_inserts")
+      .desc("lines inserted with the SRRIP interval")
+      .precision(0);
+  brrip_inserts.name(level_string + "_cache_brrip_inserts")
+      .desc("lines inserted by BRRIP")
+      .precision(0);
+  srrip_leader_misses.name(level_string + "_cache_srrip_leader_misses")
+      .desc("misses in SRRIP leader sets")
+      .precision(0);
+  brrip_leader_misses.name(level_string + "_cache_brrip_leader_misses")
+      .desc("misses in BRRIP leader sets")
+      .precision(0);
+  psel_value.name(level_string + "_cache_psel")
+      .desc("DRRIP policy selector, above half the followers use BRRIP")
+      .precision(0);
+  psel_value = psel;
+}
+
+bool CustomLLC::send(Request& req, StatusReport& report) {
+
+  int set = get_index(req.addr);
+  int line = find_line(set, req.addr);
+
+  // cache hit? predict a near re-reference
+  if (line != -1 && !lines[line].lock) {
+    lines[line].rrpv = 0;
+    lines[line].addr = req.addr;
+    lines[line].dirty =
+        lines[line].dirty || (req.type == Request::Type::WRITE);
+
+    report.hit = true;
+    if (lines[line].prefetched) {
+      report.prefetch_useful = true;
+      lines[line].prefetched = false;
+    }
+    return true;
+  }
+
+  if (req.type == Request::Type::WRITE) {
+    report.write_miss = true;
+  } else {
+    assert(req.type == Request::Type::READ);
+    report.read_miss = true;
+  }
+
+  bool dirty = (req.type == Request::Type::WRITE);
+
+  if (req.type == Request::Type::WRITE) {
+    req.type = Request::Type::READ;
+  }
+
+  int slot = mshr.find(req.addr);
+  if (slot != -1) {
+    report.mshr_hit = true;
+
+    if (mshr[slot].prefetch) {
+      report.prefetch_late = true;
+      mshr[slot].prefetch = false;
+      if (mshr[slot].line != -1) {
+        lines[mshr[slot].line].prefetched = false;
+      }
+    }
+    if (mshr[slot].line != -1) {
+      lines[mshr[slot].line].dirty = dirty || lines[mshr[slot].line].dirty;
+    }
+    return true;
+  }
+
+  if (mshr.full()) {
+    report.mshr_unavailable = true;
+    return false;
+  }
+
+  if (!fill_on_miss) {
+    mshr.allocate(req.addr, -1, req.coreid);
+    report.mshr_allocated = true;
+    return true;
+  }
+
+  if (all_locked(set)) {
+    report.set_unavailable = true;
+    return false;
+  }
+
+  // only misses that fill a line take part in the duel
+  duel(set);
+
+  int newline = allocate_line(set, req.addr, report);
+  if (newline == -1) {
+    return false;
+  }
+
+  lines[newline].dirty = dirty;
+  mshr.allocate(req.addr, newline, req.coreid);
+
+  report.mshr_allocated = true;
+  return true;
+}
+
+void CustomLLC::callback(Request& req) {
+  int slot = mshr.find(req.addr);
+
+  if (slot != -1) {
+    if (mshr[slot].line != -1) {
+      lines[mshr[slot].line].lock = false;
+    }
+    released_coreid = mshr[slot].coreid;
+    mshr.release(slot);
+    releases++;
+  }
+}
+
+bool CustomLLC::can_accept(long addr) {
+  int set = get_index(addr);
+  if (find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return true;
+  }
+  return !mshr.full() && (!fill_on_miss || !all_locked(set));
+}
+
+bool CustomLLC::holds(long addr) {
+  return find_line(get_index(addr), addr) != -1 || mshr.find(addr) != -1;
+}
+
+bool CustomLLC::invalidate(long addr, bool& dirty) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line == -1 || lines[line].lock) {
+    return false;
+  }
+  dirty = lines[line].dirty;
+  lines[line].valid = false;
+  lines[line].dirty = false;
+  set_size[set]--;
+  return true;
+}
+
+void CustomLLC::install(long addr,
+                        bool dirty,
+                        int coreid,
+                        StatusReport& report) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line != -1) {
+    // already cached or being filled
+    lines[line].dirty = lines[line].dirty || dirty;
+    return;
+  }
+
+  if (all_locked(set)) {
+    report.evicted.push_back(StatusReport::Eviction{addr, dirty, coreid});
+    if (dirty) {
+      report.requests.emplace_back(addr, Request::Type::WRITE);
+    }
+    return;
+  }
+
+  line = allocate_line(set, addr, report);
+  assert(line != -1);
+  lines[line].lock = false;
+  lines[line].dirty = dirty;
+}
+
+void CustomLLC::mark_dirty(long addr) {
+  int line = find_line(get_index(addr), addr);
+  if (line != -1 && lines[line].lock) {
+    lines[line].dirty = true;
+  }
+}
+
+bool CustomLLC::prefetch(long addr, int coreid, StatusReport& report) {
+  int set = get_index(addr);
+  if (!fill_on_miss || find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return false;
+  }
+
+  if (mshr.size() + prefetch_reserve() >= mshr.capacity()) {
+    report.mshr_unavailable = true;
+    return false;
+  }
+
+  if (all_locked(set)) {
+    report.set_unavailable = true;
+    return false;
+  }
+
+  int line = allocate_line(set, addr, report);
+  assert(line != -1);
+  lines[line].prefetched = true;
+
+  int slot = mshr.allocate(addr, line, coreid);
+  mshr[slot].prefetch = true;
+
+  report.mshr_allocated = true;
+  return true;
+}
+
+int CustomLLC::find_line(int set, long addr) {
+  long tag = get_tag(addr);
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].tag == tag) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+CustomLLC::Policy CustomLLC::set_policy(int set) {
+  if (policy != Policy::DRRIP) {
+    return policy;
+  }
+  if (set % leader_stride == 0) {
+    return Policy::SRRIP;
+  }
+  if (set % leader_stride == leader_stride / 2) {
+    return Policy::BRRIP;
+  }
+  return psel > psel_max / 2 ? Policy::BRRIP : Policy::SRRIP;
+}
+
+void CustomLLC::duel(int set) {
+  if (policy != Policy::DRRIP) {
+    return;
+  }
+  if (set % leader_stride == 0) {
+    srrip_leader_misses++;
+    psel = std::min(psel + 1, psel_max);
+    psel_value = psel;
+  } else if (set % leader_stride == leader_stride / 2) {
+    brrip_leader_misses++;
+    psel = std::max(psel - 1, 0);
+    psel_value = psel;
+  }
+}
+
+int CustomLLC::find_victim(int set) {
+  int first = set * assoc;
+  if (all_locked(set)) {
+    return -1;
+  }
+  while (true) {
+    for (int i = first; i < first + int(assoc); i++) {
+      if (!lines[i].lock && lines[i].rrpv == max_rrpv) {
+        return i;
+      }
+    }
+    for (int i = first; i < first + int(assoc); i++) {
+      if (lines[i].rrpv < max_rrpv) {
+        lines[i].rrpv++;
+      }
+    }
+  }
+}
+
+int CustomLLC::allocate_line(int set, long addr, StatusReport& report) {
+  assert(find_line(set, addr) == -1);
+  int first = set * assoc;
+
+  if (set_size[set] == assoc) {
+    int victim = find_victim(set);
+    if (victim == -1) {
+      return victim;
+    }
+    evict(set, victim, report);
+  }
+
+  uint8_t rrpv = max_rrpv - 1;
+  if (set_policy(set) == Policy::BRRIP) {
+    brrip_inserts++;
+    if (++brrip_insertions < brrip_long_interval) {
+      rrpv = max_rrpv;
+    } else {
+      brrip_insertions = 0;
+    }
+  } else {
+    srrip_inserts++;
+  }
+
+  int newline = first;
+  while (lines[newline].valid) {
+    newline++;
+  }
+  assert(newline < first + int(assoc));
+  lines[newline] =
+      Line{addr, get_tag(addr), rrpv, true, false, true, false};
+  set_size[set]++;
+  return newline;
+}
+
+void CustomLLC::evict(int set, int victim, StatusReport& report) {
+  report.evictions++;
+  if (lines[victim].prefetched) {
+    report.prefetch_useless++;
+  }
+
+  report.evicted.push_back(
+      StatusReport::Eviction{lines[victim].addr, lines[victim].dirty, 0});
+
+  if (lines[victim].dirty) {
+    report.requests.emplace_back(lines[victim].addr, Request::Type::WRITE);
+  }
+
+  lines[victim].valid = false;
+  lines[victim].lock = false;
+  lines[victim].dirty = false;
+  set_size[set]--;
+}
+
+bool CustomLLC::all_locked(int set) {
+  if (set_size[set] < assoc) {
+    return false;
+  }
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (!lines[i].lock) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int CustomLLC::calc_log2(int val) {
+  int n = 0;
+  while ((val >>= 1)) n++;
+  return n;
+}
 
-bool CustomLLC::send(Request& req, StatusReport& report) { return false; }
+int CustomLLC::get_index(long addr) {
+  return (addr >> index_offset) & index_mask;
+}
 
-void CustomLLC::callback(Request& req) {}
-}
\ No newline at end of file
+long CustomLLC::get_tag(long addr) { return (addr >> tag_offset); }
+}
@@ -1,17 +1,128 @@
 #pragma once
 
 #include "Request.h"
+#include "Statistics.h"
 #include "StatusReport.h"
 #include "BaseLLC.h"
+#include "MSHRFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace ramulator {
 
+// Re-reference interval prediction (Jaleel et al., ISCA 2010). Each line
+// holds a 2-bit RRPV, the victim is a line predicted for the distant
+// future (RRPV 3). SRRIP inserts with a long interval (RRPV 2) so scans
+// leave before the working set, BRRIP mostly inserts with a distant one
+// so thrashing sets keep part of their lines. DRRIP duels the two on
+// leader sets and lets the follower sets use whichever misses less.
 struct CustomLLC : public BaseLLC {
+  //------ Internal Types ------
+  enum class Policy {
+    SRRIP,
+    BRRIP,
+    DRRIP
+  };
+
+  struct Line {
+    long addr;
+    long tag;
+    uint8_t rrpv;
+    bool lock;
+    bool dirty;
+    bool valid;
+
+    // filled by a prefetch and not hit by a demand since
+    bool prefetched;
+  };
+
+  //------ Constants ------
+  static constexpr uint8_t max_rrpv = 3;
+  // one BRRIP insertion in brrip_long_interval uses the long interval
+  static constexpr int brrip_long_interval = 32;
+  static constexpr int psel_max = 1023;
+
+  //------ Member Variables ------
+  unsigned int block_num;
+  unsigned int index_mask;
+  unsigned int index_offset;
+  unsigned int tag_offset;
+
+  // lines of set i are lines[i * assoc, (i + 1) * assoc)
+  std::vector<Line> lines;
+  std::vector<uint16_t> set_size;
+
+  MSHRFile mshr;
 
-  CustomLLC(int size, int assoc, int block_size, int num_mshr_entries);
+  Policy policy;
+
+  // set dueling: in every leader_stride sets one SRRIP and one BRRIP
+  // leader, PSEL counts up on SRRIP leader misses and down on BRRIP ones
+  unsigned int leader_stride;
+  int psel = psel_max / 2;
+  int brrip_insertions = 0;
+
+  // ------ Stats ------
+  ScalarStat srrip_inserts;
+  ScalarStat brrip_inserts;
+  ScalarStat srrip_leader_misses;
+  ScalarStat brrip_leader_misses;
+  ScalarStat psel_value;
+
+  // ------ Core Methods ------
+  // policy is srrip, brrip or drrip
+  CustomLLC(int size,
+            int assoc,
+            int block_size,
+            int num_mshr_entries,
+            const std::string& policy,
+            const std::string& level_string);
 
   virtual bool send(Request& req, StatusReport& report) override;
 
   virtual void callback(Request& req) override;
+
+  virtual bool can_accept(long addr) override;
+
+  virtual bool holds(long addr) override;
+
+  virtual bool invalidate(long addr, bool& dirty) override;
+
+  virtual void install(long addr,
+                       bool dirty,
+                       int coreid,
+                       StatusReport& report) override;
+
+  virtual void mark_dirty(long addr) override;
+
+  virtual bool prefetch(long addr, int coreid, StatusReport& report) override;
+
+  // ------ Helpers ------
+  int find_line(int set, long addr);
+
+  // the policy set inserts with
+  Policy set_policy(int set);
+
+  // count a miss in a leader set
+  void duel(int set);
+
+  // the first unlocked line at max_rrpv, aging the set until there is one;
+  // -1 if all lines are locked
+  int find_victim(int set);
+
+  int allocate_line(int set, long addr, StatusReport& report);
+
+  void evict(int set, int victim, StatusReport& report);
+
+  bool all_locked(int set);
+
+  // ------ Misc Helpers ------
+  int calc_log2(int val);
+
+  int get_index(long addr);
+
+  long get_tag(long addr);
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,84 @@
+#include "MSHRFile.h"
+
+namespace ramulator {
+
+MSHRFile::MSHRFile(int num_entries, int block_size) {
+  assert(num_entries > 0);
+  assert((block_size & (block_size - 1)) == 0);
+
+  block_offset = 0;
+  while ((block_size >>= 1)) block_offset++;
+
+  entries.resize(num_entries);
+  free_slots.reserve(num_entries);
+  for (int i = num_entries - 1; i >= 0; i--) {
+    free_slots.push_back(i);
+  }
+
+  // at most half full, so probes stay short
+  unsigned long table_size = 1;
+  while (table_size < 2ul * num_entries) table_size <<= 1;
+  table.assign(table_size, -1);
+  table_mask = table_size - 1;
+}
+
+unsigned long MSHRFile::hash(long block) const {
+  // Fibonacci hashing, spreads neighbouring blocks over the table
+  return (uint64_t(block) * 0x9e3779b97f4a7c15ull) >> 32 & table_mask;
+}
+
+int MSHRFile::find(long addr) const {
+  long block = get_block(addr);
+  for (unsigned long i = hash(block);; i = (i + 1) & table_mask) {
+    int slot = table[i];
+    if (slot == -1) {
+      return -1;
+    }
+    if (entries[slot].block_addr == block) {
+      return slot;
+    }
+  }
+}
+
+int MSHRFile::allocate(long addr, int line, int coreid) {
+  assert(find(addr) == -1);
+  if (full()) {
+    return -1;
+  }
+
+  int slot = free_slots.back();
+  free_slots.pop_back();
+
+  Entry& entry = entries[slot];
+  entry.block_addr = get_block(addr);
+  entry.line = line;
+  entry.prefetch = false;
+  entry.coreid = coreid;
+
+  unsigned long i = hash(entry.block_addr);
+  while (table[i] != -1) i = (i + 1) & table_mask;
+  table[i] = slot;
+  return slot;
+}
+
+void MSHRFile::release(int slot) {
+  unsigned long i = hash(entries[slot].block_addr);
+  while (table[i] != slot) i = (i + 1) & table_mask;
+
+  // backward shift deletion: move later entries of the probe run into the
+  // hole when their home position allows it, so no tombstones are needed
+  unsigned long hole = i;
+  for (unsigned long j = (i + 1) & table_mask; table[j] != -1;
+       j = (j + 1) & table_mask) {
+    unsigned long home = hash(entries[table[j]].block_addr);
+    // j can move to the hole unless its home lies cyclically in (hole, j]
+    if (((j - home) & table_mask) >= ((j - hole) & table_mask)) {
+      table[hole] = table[j];
+      hole = j;
+    }
+  }
+  table[hole] = -1;
+
+  free_slots.push_back(slot);
+}
+}
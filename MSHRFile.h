@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ramulator {
+
+// Miss status holding registers shared by the BaseLLC implementations.
+// A fixed pool of entries, looked up by block address through an
+// open-addressed (linear probing) table, so finding, allocating and
+// releasing an entry don't scan the pool or allocate memory.
+struct MSHRFile {
+  //------ Internal Types ------
+  // secondary misses only need the entry to exist, the LLCs keep the
+  // dirtiness of a fill on its line
+  struct Entry {
+    long block_addr;
+    // line the fill goes to, owned by the LLC
+    int line;
+    // core of the allocating request, the entry counts against it until
+    // released
+    int coreid;
+    // allocated by a prefetch no demand has merged into yet
+    bool prefetch;
+  };
+
+  //------ Member Variables ------
+  unsigned int block_offset;
+
+  std::vector<Entry> entries;
+  // slots of unused entries
+  std::vector<int> free_slots;
+
+  // hash table of entry slots, -1 is empty
+  std::vector<int> table;
+  unsigned long table_mask;
+
+  // ------ Core Methods ------
+  MSHRFile(int num_entries, int block_size);
+
+  // slot of the entry for the block of addr, or -1
+  int find(long addr) const;
+
+  // new entry for the block of addr filling line, allocated by a request
+  // of coreid, -1 if the file is full. The block must not have an entry
+  // already.
+  int allocate(long addr, int line, int coreid);
+
+  void release(int slot);
+
+  Entry& operator[](int slot) { return entries[slot]; }
+
+  bool full() const { return free_slots.empty(); }
+
+  size_t size() const { return entries.size() - free_slots.size(); }
+
+  size_t capacity() const { return entries.size(); }
+
+  // ------ Misc Helpers ------
+  long get_block(long addr) const { return addr >> block_offset; }
+
+  unsigned long hash(long block) const;
+};
+}
@@ -0,0 +1,203 @@
+#include "Prefetcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+namespace ramulator {
+
+Prefetcher::Prefetcher(int block_size, int degree) : degree(degree) {
+  assert((block_size & (block_size - 1)) == 0);
+  assert(degree > 0);
+  block_offset = 0;
+  while ((block_size >>= 1)) block_offset++;
+}
+
+std::unique_ptr<Prefetcher> Prefetcher::create(const std::string& type,
+                                               int block_size,
+                                               int degree) {
+  if (type == "stream") {
+    return std::unique_ptr<Prefetcher>(
+        new StreamPrefetcher(block_size, degree));
+  } else if (type == "stride") {
+    return std::unique_ptr<Prefetcher>(
+        new StridePrefetcher(block_size, degree));
+  } else if (type == "best_offset") {
+    return std::unique_ptr<Prefetcher>(
+        new BestOffsetPrefetcher(block_size, degree));
+  }
+  fprintf(stderr, "unknown prefetcher %s, expected stream, stride or "
+          "best_offset\n", type.c_str());
+  std::terminate();
+}
+
+void Prefetcher::propose(long addr, long block, std::vector<long>& prefetches) {
+  long prefetch_addr = block << block_offset;
+  if ((prefetch_addr >> page_offset) == (addr >> page_offset)) {
+    prefetches.push_back(prefetch_addr);
+  }
+}
+
+//------ Stream ------
+
+StreamPrefetcher::StreamPrefetcher(int block_size, int degree)
+    : Prefetcher(block_size, degree),
+      streams(num_streams, Stream{0, 0, 0, 0, false}) {}
+
+void StreamPrefetcher::access(long addr,
+                              int coreid,
+                              bool miss,
+                              std::vector<long>& prefetches) {
+  long block = get_block(addr);
+  accesses++;
+
+  Stream* match = nullptr;
+  for (auto& s : streams) {
+    if (s.valid && std::labs(block - s.last_block) <= window) {
+      match = &s;
+      break;
+    }
+  }
+
+  if (!match) {
+    // only misses start streams, replacing the least recently used
+    if (!miss) {
+      return;
+    }
+    Stream* victim = &streams[0];
+    for (auto& s : streams) {
+      if (!s.valid) {
+        victim = &s;
+        break;
+      }
+      if (s.last_use < victim->last_use) {
+        victim = &s;
+      }
+    }
+    *victim = Stream{block, 0, 0, accesses, true};
+    return;
+  }
+
+  match->last_use = accesses;
+  if (block == match->last_block) {
+    return;
+  }
+  int direction = block > match->last_block ? 1 : -1;
+  if (direction == match->direction) {
+    match->confidence++;
+  } else {
+    match->direction = direction;
+    match->confidence = 0;
+  }
+  match->last_block = block;
+
+  if (match->confidence >= 1) {
+    for (int k = 1; k <= degree; k++) {
+      propose(addr, block + direction * k, prefetches);
+    }
+  }
+}
+
+//------ Stride ------
+
+StridePrefetcher::StridePrefetcher(int block_size, int degree)
+    : Prefetcher(block_size, degree),
+      table(num_entries, Entry{0, 0, 0, 0, false}) {}
+
+void StridePrefetcher::access(long addr,
+                              int coreid,
+                              bool miss,
+                              std::vector<long>& prefetches) {
+  long key = (addr >> page_offset) * 64 + coreid;
+  Entry& e = table[(uint64_t(key) * 0x9e3779b97f4a7c15ull) >> 56];
+
+  if (!e.valid || e.key != key) {
+    e = Entry{key, addr, 0, 0, true};
+    return;
+  }
+
+  long stride = addr - e.last_addr;
+  if (stride == 0) {
+    return;
+  }
+  if (stride == e.stride) {
+    e.confidence++;
+  } else {
+    e.stride = stride;
+    e.confidence = 0;
+  }
+  e.last_addr = addr;
+
+  if (e.confidence >= threshold) {
+    long last_block = get_block(addr);
+    for (int k = 1; k <= degree; k++) {
+      long block = get_block(addr + e.stride * k);
+      // strides below a block would prefetch the same one again
+      if (block != last_block) {
+        propose(addr, block, prefetches);
+        last_block = block;
+      }
+    }
+  }
+}
+
+//------ Best offset ------
+
+BestOffsetPrefetcher::BestOffsetPrefetcher(int block_size, int degree)
+    : Prefetcher(block_size, degree), recent(rr_size, -1) {
+  for (int d = 1; d <= 64; d++) {
+    int n = d;
+    for (int p : {2, 3, 5}) {
+      while (n % p == 0) n /= p;
+    }
+    if (n == 1) {
+      offsets.push_back(d);
+    }
+  }
+  scores.assign(offsets.size(), 0);
+}
+
+void BestOffsetPrefetcher::access(long addr,
+                                  int coreid,
+                                  bool miss,
+                                  std::vector<long>& prefetches) {
+  // only misses train, a hit says nothing about timeliness here
+  long block = get_block(addr);
+  if (miss) {
+    long base = block - offsets[test_index];
+    if (recent[uint64_t(base) % rr_size] == base &&
+        ++scores[test_index] >= score_max) {
+      end_phase();
+    } else if (++test_index == int(offsets.size())) {
+      test_index = 0;
+      if (++round >= round_max) {
+        end_phase();
+      }
+    }
+    recent[uint64_t(block) % rr_size] = block;
+  }
+
+  if (miss && enabled) {
+    for (int k = 1; k <= degree; k++) {
+      propose(addr, block + long(best_offset) * k, prefetches);
+    }
+  }
+}
+
+void BestOffsetPrefetcher::end_phase() {
+  int best = 0;
+  for (int i = 1; i < int(offsets.size()); i++) {
+    if (scores[i] > scores[best]) {
+      best = i;
+    }
+  }
+  best_offset = offsets[best];
+  enabled = scores[best] > bad_score;
+
+  std::fill(scores.begin(), scores.end(), 0);
+  test_index = 0;
+  round = 0;
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Request.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ramulator {
+
+// Callback of prefetch requests. It forwards to the callback of the demand
+// that triggered the prefetch, so the fill reaches the caches the same
+// way; its type is what marks a Request as a prefetch.
+struct PrefetchCallback {
+  std::function<void(Request&)> demand_callback;
+
+  void operator()(Request& req) { demand_callback(req); }
+};
+
+inline bool is_prefetch(const Request& req) {
+  return req.callback.target<PrefetchCallback>() != nullptr;
+}
+
+// Prefetch engine of one cache level. It sees the demand accesses of the
+// level and proposes blocks to fetch; the Cache drops the ones the LLC
+// has no room for. Prefetches stay within the page of the access.
+struct Prefetcher {
+  //------ Member Variables ------
+  unsigned int block_offset;
+  // prefetches proposed per trigger
+  int degree;
+
+  static constexpr int page_offset = 12;
+
+  // ------ Core Methods ------
+  Prefetcher(int block_size, int degree);
+
+  virtual ~Prefetcher() {}
+
+  // a demand access of coreid to addr hit or missed in the cache, append
+  // the block addresses to prefetch to prefetches
+  virtual void access(long addr,
+                      int coreid,
+                      bool miss,
+                      std::vector<long>& prefetches) = 0;
+
+  // type is stream, stride or best_offset
+  static std::unique_ptr<Prefetcher> create(const std::string& type,
+                                            int block_size,
+                                            int degree);
+
+  // ------ Misc Helpers ------
+  long get_block(long addr) const { return addr >> block_offset; }
+
+  // queue block for prefetching if it is in the same page as addr
+  void propose(long addr, long block, std::vector<long>& prefetches);
+};
+
+// Sequential streams: a miss next to one of the last misses of a tracked
+// stream confirms its direction, then each access to it prefetches the
+// next degree blocks ahead.
+struct StreamPrefetcher : public Prefetcher {
+  struct Stream {
+    long last_block;
+    int direction;
+    int confidence;
+    long last_use;
+    bool valid;
+  };
+
+  static constexpr int num_streams = 16;
+  // blocks around the last one a miss may be to extend a stream
+  static constexpr int window = 4;
+
+  std::vector<Stream> streams;
+  long accesses = 0;
+
+  StreamPrefetcher(int block_size, int degree);
+
+  void access(long addr,
+              int coreid,
+              bool miss,
+              std::vector<long>& prefetches) override;
+};
+
+// Constant strides. Request carries no PC, so strides are learned per core
+// and page, which separates the interleaved streams of one core as long as
+// they touch different pages.
+struct StridePrefetcher : public Prefetcher {
+  struct Entry {
+    long key;
+    long last_addr;
+    long stride;
+    int confidence;
+    bool valid;
+  };
+
+  static constexpr int num_entries = 256;
+  static constexpr int threshold = 2;
+
+  std::vector<Entry> table;
+
+  StridePrefetcher(int block_size, int degree);
+
+  void access(long addr,
+              int coreid,
+              bool miss,
+              std::vector<long>& prefetches) override;
+};
+
+// Best-offset prefetching (Michaud, HPCA 2016). Learning rounds score
+// every candidate offset D by how often an access to X finds X - D among
+// the recent accesses, i.e. how often prefetching with D would have been
+// in time. The best offset of a phase is used by the next one, and
+// prefetching stops while even the best offset scores badly. Misses
+// train and trigger it.
+struct BestOffsetPrefetcher : public Prefetcher {
+  static constexpr int score_max = 31;
+  static constexpr int round_max = 100;
+  static constexpr int bad_score = 1;
+  static constexpr int rr_size = 256;
+
+  // offsets whose prime factors are 2, 3 and 5, up to 64 blocks
+  std::vector<int> offsets;
+  std::vector<int> scores;
+  // recent requests, direct mapped by block, -1 is empty
+  std::vector<long> recent;
+
+  int test_index = 0;
+  int round = 0;
+  int best_offset = 1;
+  bool enabled = true;
+
+  BestOffsetPrefetcher(int block_size, int degree);
+
+  void access(long addr,
+              int coreid,
+              bool miss,
+              std::vector<long>& prefetches) override;
+
+  // the end of a learning phase, pick its best offset
+  void end_phase();
+};
+}
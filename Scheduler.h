@@ -42,6 +42,7 @@ Current Row Policies:
 
 #include "DRAM.h"
 #include "Request.h"
+#include "Prefetcher.h"
 #include "Controller.h"
 #include "Config.h" // Saugata
 #include <vector>
@@ -171,6 +172,12 @@ private:
     function<ReqIter(ReqIter, ReqIter)> compare[int(Type::MAX)] = {
         // FCFS
         [this] (ReqIter req1, ReqIter req2) {
+            // demands before prefetches
+            if (is_prefetch(*req1) ^ is_prefetch(*req2)) {
+                if (is_prefetch(*req2)) return req1;
+                return req2;
+            }
+
             // return the request with the oldest (i.e., smallest) arrival time
             if (req1->arrive <= req2->arrive) return req1;
             return req2;},
@@ -185,6 +192,12 @@ private:
                 return req2;
             }
 
+            // demands before prefetches
+            if (is_prefetch(*req1) ^ is_prefetch(*req2)) {
+                if (is_prefetch(*req2)) return req1;
+                return req2;
+            }
+
             if (req1->arrive <= req2->arrive) return req1;
             return req2;
         },
@@ -204,6 +217,12 @@ private:
                 return req2;
             }
 
+            // demands before prefetches
+            if (is_prefetch(*req1) ^ is_prefetch(*req2)) {
+                if (is_prefetch(*req2)) return req1;
+                return req2;
+            }
+
             // if both are true or both are false, break ties by arrival time (smaller = older)
             if (req1->arrive <= req2->arrive) return req1;
             return req2;
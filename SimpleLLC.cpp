@@ -3,42 +3,49 @@
 namespace ramulator {
 
 SimpleLLC::SimpleLLC(int size, int assoc, int block_size, int num_mshr_entries)
-    : BaseLLC(size, assoc, block_size, num_mshr_entries) {
+    : BaseLLC(size, assoc, block_size, num_mshr_entries),
+      mshr(num_mshr_entries, block_size) {
 
   // Check size, block size and assoc are 2^N
   assert((size & (size - 1)) == 0);
   assert((block_size & (block_size - 1)) == 0);
   assert((assoc & (assoc - 1)) == 0);
   assert(size >= block_size);
+  // recency has to fit in a Line
+  assert(assoc <= UINT16_MAX);
 
   // Initialize cache configuration
   block_num = size / (block_size * assoc);
   index_mask = block_num - 1;
   index_offset = calc_log2(block_size);
   tag_offset = calc_log2(block_num) + index_offset;
+
+  // every set up front, nothing is allocated per access
+  lines.assign(size_t(block_num) * assoc,
+               Line{0, 0, 0, false, false, false, false});
+  set_size.assign(block_num, 0);
 }
 
 bool SimpleLLC::send(Request& req, StatusReport& report) {
 
-  // If there isn't a set, create it.
-  auto& set = get_set(req.addr);
-  Set::iterator line;
+  int set = get_index(req.addr);
+  int line;
 
   // cache hit?
   if (is_hit(set, req.addr, &line)) {
     // lines in set need to be kept in LRU order
-    // move hit line to back by inserting a copy at the end
-    // updating the dirty bit if needed
-    set.push_back(Line(req.addr,
-                       get_tag(req.addr),
-                       false,
-                       line->dirty || (req.type == Request::Type::WRITE)));
-
-    // then deleting the original line object
-    set.erase(line);
+    touch(set, line);
+    // updating the address and the dirty bit if needed
+    lines[line].addr = req.addr;
+    lines[line].dirty =
+        lines[line].dirty || (req.type == Request::Type::WRITE);
 
     // IMPORTANT: record the cache hit
     report.hit = true;
+    if (lines[line].prefetched) {
+      report.prefetch_useful = true;
+      lines[line].prefetched = false;
+    }
 
     // acknowledge that this request was handled
     return true;
@@ -60,16 +67,27 @@ bool SimpleLLC::send(Request& req, StatusReport& report) {
 
     // Is request already in MSHR?
     assert(req.type == Request::Type::READ);
-    auto mshr = hit_mshr(req.addr);
+    int slot = mshr.find(req.addr);
 
     // If request is already waiting in MSHR, update dirty bit if needed and
     // finish
-    if (mshr != mshr_entries.end()) {
+    if (slot != -1) {
       // IMPORTANT: record the MSHR hit
       report.mshr_hit = true;
 
-      // update MSHR entry dirty bit (e.g. if it's a write request)
-      mshr->second->dirty = dirty || mshr->second->dirty;
+      if (mshr[slot].prefetch) {
+        report.prefetch_late = true;
+        mshr[slot].prefetch = false;
+        if (mshr[slot].line != -1) {
+          lines[mshr[slot].line].prefetched = false;
+        }
+      }
+
+      // update the dirty bit of the line being filled (e.g. if it's a write
+      // request)
+      if (mshr[slot].line != -1) {
+        lines[mshr[slot].line].dirty = dirty || lines[mshr[slot].line].dirty;
+      }
 
       // this request was handled successfully
       return true;
@@ -77,7 +95,7 @@ bool SimpleLLC::send(Request& req, StatusReport& report) {
 
     // Request wasn't in MSHR, so allocate a MSHR entry for it
     // Is there space in MSHR?
-    if (mshr_entries.size() == num_mshr_entries) {
+    if (mshr.full()) {
       // IMPORTANT: record that MSHR was full
       report.mshr_unavailable = true;
 
@@ -85,6 +103,13 @@ bool SimpleLLC::send(Request& req, StatusReport& report) {
       return false;
     }
 
+    // Victim caches don't keep the blocks they miss on
+    if (!fill_on_miss) {
+      mshr.allocate(req.addr, -1, req.coreid);
+      report.mshr_allocated = true;
+      return true;
+    }
+
     // Check whether there is a line available for MSHR to fill once it gets the
     // result from memory
     if (all_locked(set)) {
@@ -96,16 +121,16 @@ bool SimpleLLC::send(Request& req, StatusReport& report) {
     }
 
     // allocate a new line for MSHR to eventually fill
-    auto newline = allocate_line(set, req.addr, report);
-    if (newline == set.end()) {
+    int newline = allocate_line(set, req.addr, report);
+    if (newline == -1) {
       // allocation failed, stall
       return false;
     }
 
-    newline->dirty = dirty;
+    lines[newline].dirty = dirty;
 
     // Add to MSHR entries
-    mshr_entries.push_back(make_pair(req.addr, newline));
+    mshr.allocate(req.addr, newline, req.coreid);
 
     // IMPORTANT: record that request was handled by allocating in MSHR
     report.mshr_allocated = true;
@@ -113,64 +138,111 @@ bool SimpleLLC::send(Request& req, StatusReport& report) {
   }
 }
 
-SimpleLLC::Set::iterator SimpleLLC::allocate_line(Set& set,
-                                                  long addr,
-                                                  StatusReport& report) {
+int SimpleLLC::allocate_line(int set, long addr, StatusReport& report) {
+  int first = set * assoc;
+
   // See if an eviction is needed
   if (need_eviction(set, addr)) {
-    // Get victim
-    auto victim = find_if(
-        set.begin(), set.end(), [this](Line line) { return !line.lock; });
+    // Get victim, the least recently used unlocked line
+    int victim = -1;
+    for (int i = first; i < first + int(assoc); i++) {
+      if (!lines[i].lock &&
+          (victim == -1 || lines[i].recency < lines[victim].recency)) {
+        victim = i;
+      }
+    }
 
-    if (victim == set.end()) {
+    if (victim == -1) {
       return victim;  // doesn't exist a line that's already unlocked
                       // in each level
     }
-    assert(victim != set.end());
-    evict(&set, victim, report);
+    evict(set, victim, report);
   }
 
-  // Allocate newline, with lock bit on and dirty bit off
-  set.push_back(Line(addr, get_tag(addr)));
-  auto last_element = set.end();
-  --last_element;
-  return last_element;
+  // Allocate newline in a free way, with lock bit on and dirty bit off, as
+  // the most recently used line
+  int newline = first;
+  while (lines[newline].valid) {
+    newline++;
+  }
+  assert(newline < first + int(assoc));
+  lines[newline] =
+      Line{addr, get_tag(addr), set_size[set], true, false, true, false};
+  set_size[set]++;
+  return newline;
 }
 
-void SimpleLLC::evict(Set* set, Set::iterator victim, StatusReport& report) {
+void SimpleLLC::evict(int set, int victim, StatusReport& report) {
   // IMPORTANT: record this eviction
   report.evictions++;
+  if (lines[victim].prefetched) {
+    report.prefetch_useless++;
+  }
 
-  long addr = victim->addr;
-  bool dirty = victim->dirty;
+  long addr = lines[victim].addr;
+  bool dirty = lines[victim].dirty;
+
+  report.evicted.push_back(StatusReport::Eviction{addr, dirty, 0});
 
   if (dirty) {
     // IMPORTANT: record the request to memory
     report.requests.emplace_back(addr, Request::Type::WRITE);
   }
 
-  set->erase(victim);
+  remove_line(set, victim);
+}
+
+void SimpleLLC::remove_line(int set, int line) {
+  int first = set * assoc;
+  uint16_t recency = lines[line].recency;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].recency > recency) {
+      lines[i].recency--;
+    }
+  }
+  lines[line].valid = false;
+  lines[line].lock = false;
+  lines[line].dirty = false;
+  set_size[set]--;
+}
+
+void SimpleLLC::touch(int set, int line) {
+  int first = set * assoc;
+  uint16_t recency = lines[line].recency;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].recency > recency) {
+      lines[i].recency--;
+    }
+  }
+  lines[line].recency = set_size[set] - 1;
 }
 
-bool SimpleLLC::is_hit(Set& set, long addr, Set::iterator* pos_ptr) {
-  auto pos = find_if(set.begin(), set.end(), [addr, this](Line l) {
-    return (l.tag == get_tag(addr));
-  });
+int SimpleLLC::find_line(int set, long addr) {
+  long tag = get_tag(addr);
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].tag == tag) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool SimpleLLC::is_hit(int set, long addr, int* pos_ptr) {
+  int pos = find_line(set, addr);
   *pos_ptr = pos;
-  if (pos == set.end()) {
+  if (pos == -1) {
     return false;
   }
-  return !pos->lock;
+  return !lines[pos].lock;
 }
 
-bool SimpleLLC::need_eviction(const Set& set, long addr) {
-  if (find_if(set.begin(), set.end(), [addr, this](Line l) {
-        return (get_tag(addr) == l.tag);
-      }) != set.end()) {
+bool SimpleLLC::need_eviction(int set, long addr) {
+  if (find_line(set, addr) != -1) {
     // Due to MSHR, the program can't reach here. Just for checking
     assert(false);
   } else {
-    if (set.size() < assoc) {
+    if (set_size[set] < assoc) {
       return false;
     } else {
       return true;
@@ -179,18 +251,104 @@ bool SimpleLLC::need_eviction(const Set& set, long addr) {
 }
 
 void SimpleLLC::callback(Request& req) {
-  auto it = find_if(mshr_entries.begin(),
-                    mshr_entries.end(),
-                    [&req, this](std::pair<long, Set::iterator> mshr_entry) {
-    return (align(mshr_entry.first) == align(req.addr));
-  });
+  int slot = mshr.find(req.addr);
 
-  if (it != mshr_entries.end()) {
-    it->second->lock = false;
-    mshr_entries.erase(it);
+  if (slot != -1) {
+    if (mshr[slot].line != -1) {
+      lines[mshr[slot].line].lock = false;
+    }
+    released_coreid = mshr[slot].coreid;
+    mshr.release(slot);
+    releases++;
   }
 }
 
+bool SimpleLLC::can_accept(long addr) {
+  int set = get_index(addr);
+  if (find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return true;
+  }
+  return !mshr.full() && (!fill_on_miss || !all_locked(set));
+}
+
+bool SimpleLLC::holds(long addr) {
+  return find_line(get_index(addr), addr) != -1 || mshr.find(addr) != -1;
+}
+
+bool SimpleLLC::invalidate(long addr, bool& dirty) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line == -1 || lines[line].lock) {
+    return false;
+  }
+  dirty = lines[line].dirty;
+  remove_line(set, line);
+  return true;
+}
+
+void SimpleLLC::install(long addr,
+                        bool dirty,
+                        int coreid,
+                        StatusReport& report) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line != -1) {
+    // already cached or being filled
+    lines[line].dirty = lines[line].dirty || dirty;
+    if (!lines[line].lock) {
+      touch(set, line);
+    }
+    return;
+  }
+
+  if (all_locked(set)) {
+    report.evicted.push_back(StatusReport::Eviction{addr, dirty, coreid});
+    if (dirty) {
+      report.requests.emplace_back(addr, Request::Type::WRITE);
+    }
+    return;
+  }
+
+  line = allocate_line(set, addr, report);
+  assert(line != -1);
+  lines[line].lock = false;
+  lines[line].dirty = dirty;
+}
+
+void SimpleLLC::mark_dirty(long addr) {
+  int line = find_line(get_index(addr), addr);
+  if (line != -1 && lines[line].lock) {
+    lines[line].dirty = true;
+  }
+}
+
+bool SimpleLLC::prefetch(long addr, int coreid, StatusReport& report) {
+  int set = get_index(addr);
+  if (!fill_on_miss || find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return false;
+  }
+
+  if (mshr.size() + prefetch_reserve() >= mshr.capacity()) {
+    report.mshr_unavailable = true;
+    return false;
+  }
+
+  if (all_locked(set)) {
+    report.set_unavailable = true;
+    return false;
+  }
+
+  int line = allocate_line(set, addr, report);
+  assert(line != -1);
+  lines[line].prefetched = true;
+
+  int slot = mshr.allocate(addr, line, coreid);
+  mshr[slot].prefetch = true;
+
+  report.mshr_allocated = true;
+  return true;
+}
+
 int SimpleLLC::calc_log2(int val) {
   int n = 0;
   while ((val >>= 1)) n++;
@@ -206,33 +364,16 @@ long SimpleLLC::get_tag(long addr) { return (addr >> tag_offset); }
 // Align the address to cache line size
 long SimpleLLC::align(long addr) { return (addr & ~(block_size - 1l)); }
 
-SimpleLLC::Set& SimpleLLC::get_set(long addr) {
-  if (sets.find(get_index(addr)) == sets.end()) {
-    sets.insert(make_pair(get_index(addr), Set()));
-  }
-  return sets[get_index(addr)];
-}
-
-std::vector<std::pair<long, SimpleLLC::Set::iterator>>::iterator
-SimpleLLC::hit_mshr(long addr) {
-  auto mshr_it =
-      find_if(mshr_entries.begin(),
-              mshr_entries.end(),
-              [addr, this](std::pair<long, Set::iterator> mshr_entry) {
-        return (align(mshr_entry.first) == align(addr));
-      });
-  return mshr_it;
-}
-
-bool SimpleLLC::all_locked(const Set& set) {
-  if (set.size() < assoc) {
+bool SimpleLLC::all_locked(int set) {
+  if (set_size[set] < assoc) {
     return false;
   }
-  for (const auto& line : set) {
-    if (!line.lock) {
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (!lines[i].lock) {
       return false;
     }
   }
   return true;
 }
-}
\ No newline at end of file
+}
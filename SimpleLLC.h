@@ -1,9 +1,10 @@
 #pragma once
 
 #include "BaseLLC.h"
+#include "MSHRFile.h"
 
-#include <list>
-#include <map>
+#include <cstdint>
+#include <vector>
 #include <algorithm>
 
 namespace ramulator {
@@ -15,19 +16,20 @@ struct SimpleLLC : public BaseLLC {
     long addr;
     long tag;
 
+    // position in the set's LRU order, 0 is the least recently used of the
+    // valid lines
+    uint16_t recency;
+
     // When the lock is on, the line is waiting for data from memory
     bool lock;
 
     bool dirty;
 
-    Line(long addr, long tag)
-        : addr(addr), tag(tag), lock(true), dirty(false) {}
-    Line(long addr, long tag, bool lock, bool dirty)
-        : addr(addr), tag(tag), lock(lock), dirty(dirty) {}
-  };
+    bool valid;
 
-  // a cache set is a list of cache lines
-  using Set = std::list<Line>;
+    // filled by a prefetch and not hit by a demand since
+    bool prefetched;
+  };
 
   //------ Member Variables ------
   // helpers derived from configuration
@@ -36,11 +38,13 @@ struct SimpleLLC : public BaseLLC {
   unsigned int index_offset;
   unsigned int tag_offset;
 
-  // cache data storage
-  std::map<int, Set> sets;
+  // cache data storage, allocated once: the lines of set i are
+  // lines[i * assoc, (i + 1) * assoc), set_size[i] of them valid
+  std::vector<Line> lines;
+  std::vector<uint16_t> set_size;
 
-  // MSHR
-  std::vector<std::pair<long, Set::iterator>> mshr_entries;
+  // MSHR, entries fill a line index
+  MSHRFile mshr;
 
   // ------ Core Methods ------
   SimpleLLC(int size, int assoc, int block_size, int num_mshr_entries);
@@ -49,14 +53,38 @@ struct SimpleLLC : public BaseLLC {
 
   virtual void callback(Request& req) override;
 
+  virtual bool can_accept(long addr) override;
+
+  virtual bool holds(long addr) override;
+
+  virtual bool invalidate(long addr, bool& dirty) override;
+
+  virtual void install(long addr,
+                       bool dirty,
+                       int coreid,
+                       StatusReport& report) override;
+
+  virtual void mark_dirty(long addr) override;
+
+  virtual bool prefetch(long addr, int coreid, StatusReport& report) override;
+
   // ------ Helpers ------
-  bool is_hit(Set& set, long addr, Set::iterator* pos_ptr);
+  // line index of the valid line with the tag of addr, or -1
+  int find_line(int set, long addr);
+
+  bool is_hit(int set, long addr, int* pos_ptr);
+
+  // make the line the most recently used of its set
+  void touch(int set, int line);
 
-  Set::iterator allocate_line(Set& set, long addr, StatusReport& report);
+  int allocate_line(int set, long addr, StatusReport& report);
 
-  void evict(Set* set, Set::iterator victim, StatusReport& report);
+  void evict(int set, int victim, StatusReport& report);
 
-  bool need_eviction(const Set& set, long addr);
+  // invalidate a line, the lines after it in LRU order move up
+  void remove_line(int set, int line);
+
+  bool need_eviction(int set, long addr);
 
   // ------ Misc Helpers ------
   int calc_log2(int val);
@@ -67,10 +95,6 @@ struct SimpleLLC : public BaseLLC {
 
   long align(long addr);
 
-  Set& get_set(long addr);
-
-  std::vector<std::pair<long, Set::iterator>>::iterator hit_mshr(long addr);
-
-  bool all_locked(const Set& set);
+  bool all_locked(int set);
 };
-}
\ No newline at end of file
+}
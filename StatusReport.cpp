@@ -32,4 +32,33 @@ void StatusReport::update_send_stats(ScalarStat& cache_total_miss,
     cache_set_unavailable++;
   }
 }
+
+void StatusReport::update_core_send_stats(int core,
+                                          VectorStat& cache_total_miss,
+                                          VectorStat& cache_write_miss,
+                                          VectorStat& cache_read_miss,
+                                          VectorStat& cache_mshr_hit,
+                                          VectorStat& cache_mshr_unavailable,
+                                          VectorStat& cache_set_unavailable) {
+  if (write_miss || read_miss) {
+    cache_total_miss[core]++;
+    if (write_miss) {
+      cache_write_miss[core]++;
+    } else {
+      cache_read_miss[core]++;
+    }
+  }
+
+  if (mshr_hit) {
+    cache_mshr_hit[core]++;
+  }
+
+  if (mshr_unavailable) {
+    cache_mshr_unavailable[core]++;
+  }
+
+  if (set_unavailable) {
+    cache_set_unavailable[core]++;
+  }
+}
 }
\ No newline at end of file
@@ -9,6 +9,12 @@
 namespace ramulator {
 
 struct StatusReport {
+  struct Eviction {
+    long addr;
+    bool dirty;
+    int coreid;
+  };
+
   bool hit = false;
   bool write_miss = false;
   bool read_miss = false;
@@ -17,6 +23,15 @@ struct StatusReport {
   bool set_unavailable = false;
   bool mshr_allocated = false;
   int evictions = 0;
+  // a demand hit a prefetched line for the first time
+  bool prefetch_useful = false;
+  // a demand merged into a prefetch still being filled
+  bool prefetch_late = false;
+  // prefetched lines evicted without a demand hit
+  int prefetch_useless = 0;
+  // every evicted line
+  std::vector<Eviction> evicted;
+  // writebacks of the dirty ones to memory
   std::vector<Request> requests;
 
   void update_send_stats(ScalarStat& cache_total_miss,
@@ -25,5 +40,14 @@ struct StatusReport {
                          ScalarStat& cache_mshr_hit,
                          ScalarStat& cache_mshr_unavailable,
                          ScalarStat& cache_set_unavailable);
+
+  // the same for the per-core stats of core
+  void update_core_send_stats(int core,
+                              VectorStat& cache_total_miss,
+                              VectorStat& cache_write_miss,
+                              VectorStat& cache_read_miss,
+                              VectorStat& cache_mshr_hit,
+                              VectorStat& cache_mshr_unavailable,
+                              VectorStat& cache_set_unavailable);
 };
 }
\ No newline at end of file
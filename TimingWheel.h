@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace ramulator {
+
+// Calendar queue of items keyed by the cycle they complete in. Items less
+// than num_slots cycles ahead go into the slot of their cycle, later ones
+// wait in an ordered overflow map. Expiring a cycle only touches the
+// items due in it. Items due in the same cycle come out in the order they
+// were pushed.
+template <typename T>
+struct TimingWheel {
+  //------ Member Variables ------
+  std::vector<std::vector<std::pair<long, T>>> slots;
+  long slot_mask;
+
+  std::multimap<long, T> overflow;
+
+  // items pushed for a cycle that has already been expired, and a spare
+  // to swap with so f may push while they are handed out
+  std::vector<T> late;
+  std::vector<T> late_spare;
+
+  // last expired cycle
+  long current = -1;
+  size_t count = 0;
+
+  // ------ Core Methods ------
+  // num_slots must be a power of two, ideally above the longest latency
+  explicit TimingWheel(int num_slots = 64)
+      : slots(num_slots), slot_mask(num_slots - 1) {
+    assert((num_slots & (num_slots - 1)) == 0);
+  }
+
+  void push(long when, const T& item) {
+    count++;
+    if (when <= current) {
+      late.push_back(item);
+    } else if (when - current <= slot_mask) {
+      slots[when & slot_mask].emplace_back(when, item);
+    } else {
+      overflow.emplace(when, item);
+    }
+  }
+
+  // hand every item due at or before now to f, by completion cycle. Items
+  // f pushes for a cycle up to now are handed out by the next call.
+  template <typename F>
+  void expire(long now, F f) {
+    late.swap(late_spare);
+    for (auto& item : late_spare) {
+      f(item);
+    }
+    count -= late_spare.size();
+    late_spare.clear();
+
+    for (long t = current + 1; t <= now; t++) {
+      current = t;
+      // overflow items of t were pushed before any in its slot
+      auto end = overflow.upper_bound(t);
+      for (auto it = overflow.begin(); it != end; ++it) {
+        f(it->second);
+        count--;
+      }
+      overflow.erase(overflow.begin(), end);
+
+      auto& slot = slots[t & slot_mask];
+      for (auto& item : slot) {
+        assert(item.first == t);
+        f(item.second);
+      }
+      count -= slot.size();
+      slot.clear();
+    }
+  }
+
+  size_t size() const { return count; }
+
+  bool empty() const { return count == 0; }
+};
+}
@@ -1,18 +1,500 @@
 #include "WaypartLLC.h"
 
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
 namespace ramulator {
 
 WaypartLLC::WaypartLLC(int size,
                        int assoc,
                        int block_size,
-                       int num_mshr_entries)
-    : BaseLLC(size, assoc, block_size, num_mshr_entries) {}
+                       int num_mshr_entries,
+                       int num_cores,
+                       long epoch,
+                       const std::string& level_string)
+    : BaseLLC(size, assoc, block_size, num_mshr_entries),
+      mshr(num_mshr_entries, block_size),
+      num_cores(std::max(num_cores, 1)),
+      epoch(epoch) {
+
+  // Check size, block size and assoc are 2^N
+  assert((size & (size - 1)) == 0);
+  assert((block_size & (block_size - 1)) == 0);
+  assert((assoc & (assoc - 1)) == 0);
+  assert(size >= block_size);
+  assert(assoc <= UINT16_MAX);
+  assert(this->num_cores <= UINT16_MAX);
+  assert(epoch > 0);
+
+  block_num = size / (block_size * assoc);
+  index_mask = block_num - 1;
+  index_offset = calc_log2(block_size);
+  tag_offset = calc_log2(block_num) + index_offset;
+
+  lines.assign(size_t(block_num) * assoc,
+               Line{0, 0, 0, 0, false, false, false, false});
+  set_size.assign(block_num, 0);
+
+  // start from an even split, the remainder to the lowest cores
+  allocation.assign(this->num_cores, assoc / this->num_cores);
+  for (int c = 0; c < int(assoc % this->num_cores); c++) {
+    allocation[c]++;
+  }
+
+  // 32 sampled sets are enough for the monitors to track the full cache
+  sample_stride = std::max(1u, block_num / 32);
+  sampled_sets = (block_num + sample_stride - 1) / sample_stride;
+  atd.assign(size_t(this->num_cores) * sampled_sets * assoc, -1);
+  way_hits.assign(size_t(this->num_cores) * assoc, 0);
+  set_owned.assign(this->num_cores, 0);
+
+  core_hits.init(this->num_cores)
+      .name(level_string + "_cache_core_hits")
+      .desc("cache hit count per core")
+      .precision(0);
+  core_misses.init(this->num_cores)
+      .name(level_string + "_cache_core_misses")
+      .desc("cache miss count per core")
+      .precision(0);
+  core_occupancy.init(this->num_cores)
+      .name(level_string + "_cache_core_occupancy")
+      .desc("lines held per core at the last repartition")
+      .precision(0);
+  core_ways.init(this->num_cores)
+      .name(level_string + "_cache_core_ways")
+      .desc("ways allocated per core")
+      .precision(0);
+  repartitions.name(level_string + "_cache_repartitions")
+      .desc("number of way allocations computed")
+      .precision(0);
+
+  for (int c = 0; c < this->num_cores; c++) {
+    core_ways[c] = allocation[c];
+  }
+}
+
+bool WaypartLLC::send(Request& req, StatusReport& report) {
+
+  int set = get_index(req.addr);
+  int core = get_core(req);
+  int line = find_line(set, req.addr);
+
+  // cache hit?
+  if (line != -1 && !lines[line].lock) {
+    touch(set, line);
+    lines[line].addr = req.addr;
+    lines[line].dirty =
+        lines[line].dirty || (req.type == Request::Type::WRITE);
+
+    report.hit = true;
+    if (lines[line].prefetched) {
+      report.prefetch_useful = true;
+      lines[line].prefetched = false;
+    }
+    core_hits[core]++;
+    observe(set, core, req.addr);
+    return true;
+  }
+
+  if (req.type == Request::Type::WRITE) {
+    report.write_miss = true;
+  } else {
+    assert(req.type == Request::Type::READ);
+    report.read_miss = true;
+  }
+
+  bool dirty = (req.type == Request::Type::WRITE);
+
+  if (req.type == Request::Type::WRITE) {
+    req.type = Request::Type::READ;
+  }
+
+  // merge into the outstanding miss of the block
+  int slot = mshr.find(req.addr);
+  if (slot != -1) {
+    report.mshr_hit = true;
+
+    if (mshr[slot].prefetch) {
+      report.prefetch_late = true;
+      mshr[slot].prefetch = false;
+      if (mshr[slot].line != -1) {
+        lines[mshr[slot].line].prefetched = false;
+      }
+    }
+    if (mshr[slot].line != -1) {
+      lines[mshr[slot].line].dirty = dirty || lines[mshr[slot].line].dirty;
+    }
+
+    core_misses[core]++;
+    observe(set, core, req.addr);
+    return true;
+  }
+
+  if (mshr.full()) {
+    report.mshr_unavailable = true;
+    return false;
+  }
+
+  if (!fill_on_miss) {
+    mshr.allocate(req.addr, -1, req.coreid);
+    report.mshr_allocated = true;
+    core_misses[core]++;
+    observe(set, core, req.addr);
+    return true;
+  }
+
+  if (all_locked(set)) {
+    report.set_unavailable = true;
+    return false;
+  }
+
+  int newline = allocate_line(set, req.addr, core, report);
+  if (newline == -1) {
+    return false;
+  }
+
+  lines[newline].dirty = dirty;
+  mshr.allocate(req.addr, newline, req.coreid);
+
+  report.mshr_allocated = true;
+  core_misses[core]++;
+  observe(set, core, req.addr);
+  return true;
+}
+
+void WaypartLLC::callback(Request& req) {
+  int slot = mshr.find(req.addr);
+
+  if (slot != -1) {
+    if (mshr[slot].line != -1) {
+      lines[mshr[slot].line].lock = false;
+    }
+    released_coreid = mshr[slot].coreid;
+    mshr.release(slot);
+    releases++;
+  }
+}
+
+bool WaypartLLC::can_accept(long addr) {
+  int set = get_index(addr);
+  if (find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return true;
+  }
+  return !mshr.full() && (!fill_on_miss || !all_locked(set));
+}
+
+bool WaypartLLC::holds(long addr) {
+  return find_line(get_index(addr), addr) != -1 || mshr.find(addr) != -1;
+}
+
+bool WaypartLLC::invalidate(long addr, bool& dirty) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line == -1 || lines[line].lock) {
+    return false;
+  }
+  dirty = lines[line].dirty;
+  remove_line(set, line);
+  return true;
+}
+
+void WaypartLLC::install(long addr,
+                         bool dirty,
+                         int coreid,
+                         StatusReport& report) {
+  int set = get_index(addr);
+  int line = find_line(set, addr);
+  if (line != -1) {
+    // already cached or being filled
+    lines[line].dirty = lines[line].dirty || dirty;
+    if (!lines[line].lock) {
+      touch(set, line);
+    }
+    return;
+  }
+
+  if (all_locked(set)) {
+    report.evicted.push_back(StatusReport::Eviction{addr, dirty, coreid});
+    if (dirty) {
+      report.requests.emplace_back(addr, Request::Type::WRITE);
+    }
+    return;
+  }
+
+  line = allocate_line(
+      set, addr, (coreid >= 0 && coreid < num_cores) ? coreid : 0, report);
+  assert(line != -1);
+  lines[line].lock = false;
+  lines[line].dirty = dirty;
+}
+
+void WaypartLLC::mark_dirty(long addr) {
+  int line = find_line(get_index(addr), addr);
+  if (line != -1 && lines[line].lock) {
+    lines[line].dirty = true;
+  }
+}
+
+bool WaypartLLC::prefetch(long addr, int coreid, StatusReport& report) {
+  int set = get_index(addr);
+  if (!fill_on_miss || find_line(set, addr) != -1 || mshr.find(addr) != -1) {
+    return false;
+  }
+
+  if (mshr.size() + prefetch_reserve() >= mshr.capacity()) {
+    report.mshr_unavailable = true;
+    return false;
+  }
 
-// 18-740: Way Partitioning - implement send request - refer SimpleLLC.cpp 
-bool WaypartLLC::send(Request& req, StatusReport& report) { return false; }
+  if (all_locked(set)) {
+    report.set_unavailable = true;
+    return false;
+  }
 
-// 18-740 - consult SimpleLLC for callback implementation
-void WaypartLLC::callback(Request& req) {}
+  int line = allocate_line(
+      set, addr, (coreid >= 0 && coreid < num_cores) ? coreid : 0, report);
+  assert(line != -1);
+  lines[line].prefetched = true;
+
+  int slot = mshr.allocate(addr, line, coreid);
+  mshr[slot].prefetch = true;
+
+  report.mshr_allocated = true;
+  return true;
+}
+
+int WaypartLLC::find_line(int set, long addr) {
+  long tag = get_tag(addr);
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].tag == tag) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void WaypartLLC::touch(int set, int line) {
+  int first = set * assoc;
+  uint16_t recency = lines[line].recency;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].recency > recency) {
+      lines[i].recency--;
+    }
+  }
+  lines[line].recency = set_size[set] - 1;
+}
+
+int WaypartLLC::find_victim(int set, int core) {
+  int first = set * assoc;
+  std::fill(set_owned.begin(), set_owned.end(), 0);
+  for (int i = first; i < first + int(assoc); i++) {
+    set_owned[lines[i].owner]++;
+  }
+
+  // LRU unlocked line among those pred accepts
+  auto lru = [&](const std::function<bool(const Line&)>& pred) {
+    int victim = -1;
+    for (int i = first; i < first + int(assoc); i++) {
+      if (!lines[i].lock && pred(lines[i]) &&
+          (victim == -1 || lines[i].recency < lines[victim].recency)) {
+        victim = i;
+      }
+    }
+    return victim;
+  };
+
+  int victim = -1;
+  if (set_owned[core] < allocation[core]) {
+    // take a way from a core above its allocation, else from any other
+    victim = lru([&](const Line& l) {
+      return l.owner != core && set_owned[l.owner] > allocation[l.owner];
+    });
+    if (victim == -1) {
+      victim = lru([&](const Line& l) { return l.owner != core; });
+    }
+  }
+  if (victim == -1) {
+    victim = lru([&](const Line& l) { return l.owner == core; });
+  }
+  if (victim == -1) {
+    // all of the core's lines are being filled
+    victim = lru([](const Line& l) { return true; });
+  }
+  return victim;
+}
+
+int WaypartLLC::allocate_line(int set,
+                              long addr,
+                              int core,
+                              StatusReport& report) {
+  assert(find_line(set, addr) == -1);
+  int first = set * assoc;
+
+  if (set_size[set] == assoc) {
+    int victim = find_victim(set, core);
+    if (victim == -1) {
+      return victim;
+    }
+    evict(set, victim, report);
+  }
+
+  int newline = first;
+  while (lines[newline].valid) {
+    newline++;
+  }
+  assert(newline < first + int(assoc));
+  lines[newline] =
+      Line{addr, get_tag(addr), set_size[set], uint16_t(core), true, false,
+           true, false};
+  set_size[set]++;
+  return newline;
+}
+
+void WaypartLLC::evict(int set, int victim, StatusReport& report) {
+  report.evictions++;
+  if (lines[victim].prefetched) {
+    report.prefetch_useless++;
+  }
+
+  report.evicted.push_back(StatusReport::Eviction{
+      lines[victim].addr, lines[victim].dirty, lines[victim].owner});
+
+  if (lines[victim].dirty) {
+    report.requests.emplace_back(lines[victim].addr, Request::Type::WRITE);
+  }
+
+  remove_line(set, victim);
+}
+
+void WaypartLLC::remove_line(int set, int line) {
+  int first = set * assoc;
+  uint16_t recency = lines[line].recency;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (lines[i].valid && lines[i].recency > recency) {
+      lines[i].recency--;
+    }
+  }
+  lines[line].valid = false;
+  lines[line].lock = false;
+  lines[line].dirty = false;
+  set_size[set]--;
+}
+
+bool WaypartLLC::all_locked(int set) {
+  if (set_size[set] < assoc) {
+    return false;
+  }
+  int first = set * assoc;
+  for (int i = first; i < first + int(assoc); i++) {
+    if (!lines[i].lock) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void WaypartLLC::observe(int set, int core, long addr) {
+  if (set % sample_stride == 0) {
+    long* stack =
+        &atd[(size_t(core) * sampled_sets + set / sample_stride) * assoc];
+    long tag = get_tag(addr);
+
+    // a hit at position p would have hit with p + 1 or more ways
+    int pos = std::find(stack, stack + assoc, tag) - stack;
+    if (pos < int(assoc)) {
+      way_hits[size_t(core) * assoc + pos]++;
+    } else {
+      pos = assoc - 1;
+    }
+    std::copy_backward(stack, stack + pos, stack + pos + 1);
+    stack[0] = tag;
+  }
+
+  if (++epoch_accesses >= epoch) {
+    repartition();
+    epoch_accesses = 0;
+  }
+}
+
+long WaypartLLC::utility(int core, int ways) {
+  long hits = 0;
+  for (int p = 0; p < ways; p++) {
+    hits += way_hits[size_t(core) * assoc + p];
+  }
+  return hits;
+}
+
+void WaypartLLC::repartition() {
+  repartitions++;
+
+  long total = 0;
+  for (long hits : way_hits) {
+    total += hits;
+  }
+
+  // with nothing measured keep the current allocation
+  if (total > 0) {
+    // every core keeps a way when there are enough of them
+    int min_ways = int(assoc) >= num_cores ? 1 : 0;
+    std::vector<int> alloc(num_cores, min_ways);
+    int balance = assoc - min_ways * num_cores;
+
+    // lookahead: give the ways to the core with the highest marginal
+    // utility per way, looking past the plateaus of its utility curve
+    while (balance > 0) {
+      int best_core = -1;
+      int best_ways = 0;
+      double best_mu = -1;
+      for (int c = 0; c < num_cores; c++) {
+        long base = utility(c, alloc[c]);
+        for (int k = 1; k <= balance && alloc[c] + k <= int(assoc); k++) {
+          double mu = double(utility(c, alloc[c] + k) - base) / k;
+          if (mu > best_mu) {
+            best_core = c;
+            best_ways = k;
+            best_mu = mu;
+          }
+        }
+      }
+      alloc[best_core] += best_ways;
+      balance -= best_ways;
+    }
+    allocation = alloc;
+
+    // age the monitors so the next epoch weighs recent behaviour more
+    for (long& hits : way_hits) {
+      hits /= 2;
+    }
+  }
+
+  std::fill(set_owned.begin(), set_owned.end(), 0);
+  for (const Line& l : lines) {
+    if (l.valid) {
+      set_owned[l.owner]++;
+    }
+  }
+  for (int c = 0; c < num_cores; c++) {
+    core_ways[c] = allocation[c];
+    core_occupancy[c] = set_owned[c];
+  }
+}
+
+int WaypartLLC::get_core(const Request& req) {
+  // writebacks and requests without a core count against core 0
+  return (req.coreid >= 0 && req.coreid < num_cores) ? req.coreid : 0;
+}
+
+int WaypartLLC::calc_log2(int val) {
+  int n = 0;
+  while ((val >>= 1)) n++;
+  return n;
+}
+
+int WaypartLLC::get_index(long addr) {
+  return (addr >> index_offset) & index_mask;
+}
 
-// 18-740 other methods here
+long WaypartLLC::get_tag(long addr) { return (addr >> tag_offset); }
 }
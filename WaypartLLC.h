@@ -1,25 +1,144 @@
 #pragma once
 
 #include "Request.h"
+#include "Statistics.h"
 #include "StatusReport.h"
 #include "BaseLLC.h"
+#include "MSHRFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace ramulator {
 
+// Utility-based cache partitioning (Qureshi and Patt, MICRO 2006). Every
+// core gets a number of ways, enforced on replacement: a core below its
+// allocation in a set evicts another core's line, a core at or above it
+// evicts its own. The allocations are recomputed every epoch (counted in
+// LLC accesses) from per-core utility monitors, shadow tag directories
+// over a sample of the sets that count the hits each LRU stack position
+// would have given that core had it been alone in the cache.
 struct WaypartLLC : public BaseLLC {
+  //------ Internal Types ------
+  struct Line {
+    long addr;
+    long tag;
+    uint16_t recency;
+    // core the line was filled for
+    uint16_t owner;
+    bool lock;
+    bool dirty;
+    bool valid;
+
+    // filled by a prefetch and not hit by a demand since
+    bool prefetched;
+  };
+
+  //------ Member Variables ------
+  unsigned int block_num;
+  unsigned int index_mask;
+  unsigned int index_offset;
+  unsigned int tag_offset;
+
+  // lines of set i are lines[i * assoc, (i + 1) * assoc)
+  std::vector<Line> lines;
+  std::vector<uint16_t> set_size;
+
+  MSHRFile mshr;
+
+  int num_cores;
+  long epoch;
+  long epoch_accesses = 0;
+
+  // ways each core may hold in a set
+  std::vector<int> allocation;
+
+  // utility monitors: every sample_stride-th set is shadowed, with the
+  // tags of core c's shadow set s at atd[(c * sampled_sets + s) * assoc],
+  // most recently used first (-1 is empty)
+  unsigned int sample_stride;
+  unsigned int sampled_sets;
+  std::vector<long> atd;
+  // hits per core per LRU stack position, position 0 is the MRU
+  std::vector<long> way_hits;
 
-  WaypartLLC(int size, int assoc, int block_size, int num_mshr_entries);
-  // 18-740
-  // your cache and MSHR data structures here 
-  // functions to allocate/hit/evict etc. here
-  // see SimpleLLC for reference.
+  // scratch, lines per core in the set being replaced
+  std::vector<int> set_owned;
+
+  // ------ Stats ------
+  VectorStat core_hits;
+  VectorStat core_misses;
+  // lines held per core at the last repartition
+  VectorStat core_occupancy;
+  VectorStat core_ways;
+  ScalarStat repartitions;
+
+  // ------ Core Methods ------
+  WaypartLLC(int size,
+             int assoc,
+             int block_size,
+             int num_mshr_entries,
+             int num_cores,
+             long epoch,
+             const std::string& level_string);
 
   // send a request to the cache system (i.e. process a request)
   virtual bool send(Request& req, StatusReport& report) override;
 
   // this is called by the memory when it has a response
   // free corresponding MSHR entry and update cache data
-  // use SimpleLLC::callback as reference
   virtual void callback(Request& req) override;
+
+  virtual bool can_accept(long addr) override;
+
+  virtual bool holds(long addr) override;
+
+  virtual bool invalidate(long addr, bool& dirty) override;
+
+  virtual void install(long addr,
+                       bool dirty,
+                       int coreid,
+                       StatusReport& report) override;
+
+  virtual void mark_dirty(long addr) override;
+
+  virtual bool prefetch(long addr, int coreid, StatusReport& report) override;
+
+  // ------ Helpers ------
+  int find_line(int set, long addr);
+
+  void touch(int set, int line);
+
+  // the line to replace for core in a full set, -1 if all are locked
+  int find_victim(int set, int core);
+
+  int allocate_line(int set, long addr, int core, StatusReport& report);
+
+  void evict(int set, int victim, StatusReport& report);
+
+  void remove_line(int set, int line);
+
+  bool all_locked(int set);
+
+  // ------ Partitioning ------
+  // a handled access of core: updates its utility monitor if set is
+  // sampled and repartitions at the end of the epoch
+  void observe(int set, int core, long addr);
+
+  // hits core would get with ways ways, from its monitor
+  long utility(int core, int ways);
+
+  // lookahead allocation from the monitors, then ages them
+  void repartition();
+
+  // ------ Misc Helpers ------
+  int get_core(const Request& req);
+
+  int calc_log2(int val);
+
+  int get_index(long addr);
+
+  long get_tag(long addr);
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+namespace ramulator {
+
+// Dirty blocks a cache has evicted, waiting to be written to memory. The
+// buffer is bounded and drained in FIFO order; while it is full the cache
+// stops taking requests that could evict another dirty block. A capacity
+// of 0 disables it and writebacks go straight to memory.
+struct WritebackBuffer {
+  //------ Internal Types ------
+  struct Entry {
+    // cycle the writeback has made it through the cache
+    long ready;
+    long block;
+  };
+
+  //------ Member Variables ------
+  unsigned int capacity;
+  unsigned int block_offset;
+  std::deque<Entry> entries;
+
+  // draining down to the low watermark after crossing the high one
+  bool draining = false;
+
+  // most entries ever used
+  size_t max_size = 0;
+
+  // ------ Core Methods ------
+  WritebackBuffer(int capacity, int block_size) : capacity(capacity) {
+    block_offset = 0;
+    while ((block_size >>= 1)) block_offset++;
+  }
+
+  bool enabled() const { return capacity > 0; }
+
+  bool full() const { return enabled() && entries.size() >= capacity; }
+
+  size_t size() const { return entries.size(); }
+
+  bool contains(long addr) const {
+    long block = addr >> block_offset;
+    for (auto& entry : entries) {
+      if (entry.block == block) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // false when the buffer is full
+  bool push(long ready, long addr) {
+    if (full()) {
+      return false;
+    }
+    entries.push_back(Entry{ready, addr >> block_offset});
+    if (entries.size() > max_size) {
+      max_size = entries.size();
+    }
+    return true;
+  }
+
+  // is the oldest writeback ready to go to memory by clk
+  bool ready(long clk) const {
+    return !entries.empty() && entries.front().ready <= clk;
+  }
+
+  long front_addr() const { return entries.front().block << block_offset; }
+
+  void pop() { entries.pop_front(); }
+};
+}
@@ -0,0 +1,239 @@
+import argparse
+
+import m5
+from m5.objects import *
+
+# One configuration for every protocol, benchmark and cache geometry:
+#
+#   ./gem5.opt configs/cc_config.py --protocol adapt --cores 4 \
+#       --block-offset 4 --set-bit 0 --cache-size-bit 11 \
+#       --invalid-threshold 0 --invalidation-ratio 4 binaries/complex_matrix
+#
+# Every core runs the binary as its own process with a shared region mapped
+# at --shared-base in all of them. Only the cacheable ranges (by default the
+# shared region) go through the coherent caches. Stats are written to gem5's
+# output directory, set with gem5's own -d/--outdir option; see sweep.py for
+# running many points at once.
+
+def parse_range(text):
+    start, end = text.split(':')
+    return AddrRange(int(start, 0), int(end, 0))
+
+parser = argparse.ArgumentParser()
+parser.add_argument('binary')
+parser.add_argument('--protocol', default='mesi',
+                    choices=['mesi', 'dragon', 'hybrid', 'adapt'])
+parser.add_argument('--cores', type=int, default=2)
+parser.add_argument('--cpu-type', default='TimingSimpleCPU',
+                    help='any timing cpu model in m5.objects, e.g. '
+                         'TimingSimpleCPU, MinorCPU or O3CPU')
+parser.add_argument('--args', default='{core}',
+                    help='binary arguments, {core} and {cores} are replaced '
+                         'by the core id and the number of cores')
+parser.add_argument('--clock', default='1GHz')
+parser.add_argument('--mem-size', default='512MB')
+
+geometry = parser.add_argument_group('caches')
+geometry.add_argument('--block-offset', type=int, default=3,
+                      help='log2 of the block size')
+geometry.add_argument('--set-bit', type=int, default=1,
+                      help='log2 of the number of sets')
+geometry.add_argument('--cache-size-bit', type=int, default=10,
+                      help='log2 of the cache size')
+geometry.add_argument('--invalid-threshold', type=int, default=None,
+                      help='hybrid/adapt updates before invalidating '
+                           '(default 5 for hybrid, 0 for adapt)')
+geometry.add_argument('--invalidation-ratio', type=int, default=2,
+                      help='adapt write run length that lowers the threshold')
+geometry.add_argument('--sector-bit', type=int, default=0,
+                      help='dragon: log2 of the sectors per block, each kept '
+                           'coherent on its own')
+geometry.add_argument('--response-latency', default='1ps')
+geometry.add_argument('--store-buffer', type=int, default=0,
+                      help='TSO store buffer entries per L1 (default 0: '
+                           'stores wait for the cache)')
+geometry.add_argument('--shared-base', type=lambda x: int(x, 0),
+                      default=0x8000,
+                      help='address of the region shared by all processes')
+geometry.add_argument('--shared-size', type=lambda x: int(x, 0),
+                      default=8192)
+geometry.add_argument('--cacheable-range', type=parse_range, action='append',
+                      metavar='START:END',
+                      help='range kept coherent, may be repeated '
+                           '(default: the shared region)')
+
+cluster = parser.add_argument_group('clusters')
+cluster.add_argument('--cluster-size', type=int, default=0,
+                     help='L1s per cluster; each cluster has a local bus '
+                          'and a ClusterCache on the global bus '
+                          '(default 0: all L1s on one bus)')
+cluster.add_argument('--l2-set-bit', type=int, default=4,
+                     help='log2 of the number of cluster cache sets')
+cluster.add_argument('--l2-cache-size-bit', type=int, default=14,
+                     help='log2 of the cluster cache size')
+
+llc = parser.add_argument_group('shared LLC')
+llc.add_argument('--llc', action='store_true',
+                 help='put an inclusive SharedLLC between the bus and memory')
+llc.add_argument('--llc-set-bit', type=int, default=10,
+                 help='log2 of the number of LLC sets')
+llc.add_argument('--llc-assoc', type=int, default=16)
+llc.add_argument('--llc-banks', type=int, default=4)
+llc.add_argument('--llc-tag-latency', default='2ns')
+llc.add_argument('--llc-hit-latency', default='10ns')
+
+bus = parser.add_argument_group('bus')
+bus.add_argument('--grant-latency', default='1ps')
+bus.add_argument('--request-latency', default='1ps')
+bus.add_argument('--bus-clock', default='1GHz')
+bus.add_argument('--bus-width', type=int, default=8,
+                 help='bytes per data beat')
+bus.add_argument('--arbitration-cycles', type=int, default=1)
+bus.add_argument('--snoop-cycles', type=int, default=1)
+bus.add_argument('--beat-cycles', type=int, default=1,
+                 help='bus cycles per data beat')
+bus.add_argument('--arbitration', default='fifo',
+                 choices=['fifo', 'round_robin', 'fixed_priority', 'age_op',
+                          'weighted'])
+bus.add_argument('--arbitration-weights', type=lambda x: [
+                     int(w) for w in x.split(',')], default=[],
+                 help='weighted: comma separated weights by cache id')
+bus.add_argument('--coherence-trace', action='store_true',
+                 help='write per cache and bus .cctrace files')
+bus.add_argument('--sharing-profile', action='store_true',
+                 help='write <bus>.sharing.txt')
+args = parser.parse_args()
+
+system = System()
+system.clk_domain = SrcClockDomain()
+system.clk_domain.clock = args.clock
+system.clk_domain.voltage_domain = VoltageDomain()
+
+system.mem_mode = 'timing'
+system.mem_ranges = [AddrRange(args.mem_size)]
+
+if args.sector_bit and args.protocol != 'dragon':
+    parser.error("--sector-bit is only supported by the dragon protocol")
+if (1 << args.block_offset) >> args.sector_bit < 8:
+    parser.error("--sector-bit leaves sectors below the 8-byte cpu access")
+
+cpu_class = getattr(m5.objects, args.cpu_type, None)
+if cpu_class is None:
+    parser.error(f"unknown cpu model {args.cpu_type}")
+system.cpu = [cpu_class(cpu_id=i) for i in range(args.cores)]
+
+def make_bus():
+    return SerializingBus(grant_latency=args.grant_latency,
+                          request_latency=args.request_latency,
+                          bus_clock=args.bus_clock,
+                          bus_width=args.bus_width,
+                          arbitration_cycles=args.arbitration_cycles,
+                          snoop_cycles=args.snoop_cycles,
+                          beat_cycles=args.beat_cycles,
+                          arbitration_policy=args.arbitration,
+                          arbitration_weights=args.arbitration_weights,
+                          coherence_trace=args.coherence_trace,
+                          sharing_profile=args.sharing_profile)
+
+system.serializing_bus = make_bus()
+
+cacheable = args.cacheable_range or [
+    AddrRange(args.shared_base, args.shared_base + args.shared_size)]
+
+# with clusters the L1s sit on their cluster's local bus and the cluster
+# caches on the global serializing_bus
+if args.cluster_size > 0:
+    if args.cores % args.cluster_size != 0:
+        parser.error("--cores must be a multiple of --cluster-size")
+    num_clusters = args.cores // args.cluster_size
+    system.local_buses = [make_bus() for c in range(num_clusters)]
+    system.l2_caches = [ClusterCache(
+        cache_id=c,
+        serializing_bus=system.serializing_bus,
+        local_bus=system.local_buses[c],
+        # the L1s' bus transactions are a sector
+        blockOffset=args.block_offset - args.sector_bit,
+        setBit=args.l2_set_bit,
+        cacheSizeBit=args.l2_cache_size_bit,
+        response_latency=args.response_latency,
+        cacheable_ranges=cacheable) for c in range(num_clusters)]
+    for c in range(num_clusters):
+        system.local_buses[c].mem_side = system.l2_caches[c].cpu_side
+    l1_bus = lambda i: system.local_buses[i // args.cluster_size]
+else:
+    l1_bus = lambda i: system.serializing_bus
+
+cache_params = dict(blockOffset=args.block_offset,
+                    setBit=args.set_bit,
+                    cacheSizeBit=args.cache_size_bit,
+                    response_latency=args.response_latency,
+                    cacheable_ranges=cacheable,
+                    store_buffer_entries=args.store_buffer)
+if args.protocol == 'mesi':
+    make_cache = lambda i: MesiCache(
+        cache_id=i, serializing_bus=l1_bus(i), **cache_params)
+elif args.protocol == 'dragon':
+    make_cache = lambda i: DragonCache(
+        cache_id=i, serializing_bus=l1_bus(i), sectorBit=args.sector_bit,
+        **cache_params)
+elif args.protocol == 'hybrid':
+    threshold = 5 if args.invalid_threshold is None \
+        else args.invalid_threshold
+    make_cache = lambda i: HybridCache(
+        cache_id=i, serializing_bus=l1_bus(i), invalidThreshold=threshold,
+        **cache_params)
+else:
+    threshold = 0 if args.invalid_threshold is None \
+        else args.invalid_threshold
+    make_cache = lambda i: AdaptCache(
+        cache_id=i, serializing_bus=l1_bus(i), invalidThreshold=threshold,
+        invalidationRatio=args.invalidation_ratio, **cache_params)
+system.l1_caches = [make_cache(i) for i in range(args.cores)]
+
+system.membus = SystemXBar()
+if args.llc:
+    system.llc = SharedLLC(serializing_bus=system.serializing_bus,
+                           setBit=args.llc_set_bit,
+                           assoc=args.llc_assoc,
+                           num_banks=args.llc_banks,
+                           tag_latency=args.llc_tag_latency,
+                           hit_latency=args.llc_hit_latency,
+                           cacheable_ranges=cacheable)
+    system.serializing_bus.mem_side = system.llc.cpu_side
+    system.llc.mem_side = system.membus.cpu_side_ports
+else:
+    system.serializing_bus.mem_side = system.membus.cpu_side_ports
+
+for i in range(args.cores):
+    system.cpu[i].icache_port = system.membus.cpu_side_ports
+    system.cpu[i].dcache_port = system.l1_caches[i].cpu_side
+    system.cpu[i].createInterruptController()
+
+system.system_port = system.membus.cpu_side_ports
+
+system.mem_ctrl = MemCtrl()
+system.mem_ctrl.dram = DDR3_1600_8x8()
+system.mem_ctrl.dram.range = system.mem_ranges[0]
+system.mem_ctrl.port = system.membus.mem_side_ports
+
+system.workload = SEWorkload.init_compatible(args.binary)
+
+processes = [Process(pid=i*100) for i in range(args.cores)]
+for i in range(args.cores):
+    processes[i].cmd = [args.binary] + \
+        args.args.format(core=i, cores=args.cores).split()
+    system.cpu[i].workload = processes[i]
+    system.cpu[i].createThreads()
+
+root = Root(full_system=False, system=system)
+m5.instantiate()
+
+for i in range(args.cores):
+    processes[i].map(args.shared_base, args.shared_base, args.shared_size,
+                     cacheable=True)
+
+m5.stats.reset()
+
+print(f"Beginning {args.protocol} simulation with {args.cores} cores")
+exit_event = m5.simulate()
+print(f"Exiting @ tick {m5.curTick()} because {exit_event.getCause()}")
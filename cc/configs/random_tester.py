@@ -0,0 +1,107 @@
+import argparse
+
+import m5
+from m5.objects import *
+
+# Random coherence stress test: a CoherenceTester drives every cache's
+# cpu_side with random reads and writes to a few contended blocks and checks
+# each value against a shadow copy of memory.
+#
+#   ./gem5.opt configs/random_tester.py --protocol hybrid --ops 2000000
+#
+# The default geometry is tiny (2 sets, 8 byte blocks, 64 byte caches) and
+# the tested blocks all map to the same set, so evictions keep racing with
+# snoops and updates.
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--protocol', default='mesi',
+                    choices=['mesi', 'dragon', 'hybrid', 'adapt'])
+parser.add_argument('--caches', type=int, default=4)
+parser.add_argument('--ops', type=int, default=1000000,
+                    help='checked operations before exiting')
+parser.add_argument('--blocks', type=int, default=8,
+                    help='number of contended blocks')
+parser.add_argument('--block-offset', type=int, default=3)
+parser.add_argument('--set-bit', type=int, default=1)
+parser.add_argument('--cache-size-bit', type=int, default=6)
+parser.add_argument('--invalid-threshold', type=int, default=2)
+parser.add_argument('--invalidation-ratio', type=int, default=2)
+parser.add_argument('--percent-reads', type=int, default=50)
+parser.add_argument('--cluster-size', type=int, default=0,
+                    help='caches per cluster behind a ClusterCache '
+                         '(default 0: all caches on one bus)')
+args = parser.parse_args()
+
+system = System()
+system.clk_domain = SrcClockDomain()
+system.clk_domain.clock = '1GHz'
+system.clk_domain.voltage_domain = VoltageDomain()
+
+system.mem_mode = 'timing'
+system.mem_ranges = [AddrRange('512MB')]
+
+system.serializing_bus = SerializingBus()
+
+geometry = dict(blockOffset=args.block_offset, setBit=args.set_bit,
+                cacheSizeBit=args.cache_size_bit)
+
+# cluster caches get the same tiny geometry, so back invalidations race too
+if args.cluster_size > 0:
+    num_clusters = (args.caches + args.cluster_size - 1) // args.cluster_size
+    system.local_buses = [SerializingBus() for c in range(num_clusters)]
+    system.l2_caches = [ClusterCache(
+        cache_id=c, serializing_bus=system.serializing_bus,
+        local_bus=system.local_buses[c], blockOffset=args.block_offset,
+        setBit=args.set_bit, cacheSizeBit=args.cache_size_bit + 1)
+        for c in range(num_clusters)]
+    for c in range(num_clusters):
+        system.local_buses[c].mem_side = system.l2_caches[c].cpu_side
+    l1_bus = lambda i: system.local_buses[i // args.cluster_size]
+else:
+    l1_bus = lambda i: system.serializing_bus
+if args.protocol == 'mesi':
+    make_cache = lambda i: MesiCache(**geometry)
+elif args.protocol == 'dragon':
+    make_cache = lambda i: DragonCache(**geometry)
+elif args.protocol == 'hybrid':
+    make_cache = lambda i: HybridCache(
+        invalidThreshold=args.invalid_threshold, **geometry)
+else:
+    make_cache = lambda i: AdaptCache(
+        invalidThreshold=args.invalid_threshold,
+        invalidationRatio=args.invalidation_ratio, **geometry)
+
+system.l1_caches = [make_cache(i) for i in range(args.caches)]
+for i, cache in enumerate(system.l1_caches):
+    cache.cache_id = i
+    cache.serializing_bus = l1_bus(i)
+
+block_size = 1 << args.block_offset
+# one block per set span, so every tested block lands in set 0
+set_span = block_size << args.set_bit
+system.tester = CoherenceTester(
+    base_addr=0x8000,
+    num_blocks=args.blocks,
+    block_size=block_size,
+    block_stride=set_span,
+    percent_reads=args.percent_reads,
+    max_ops=args.ops)
+for cache in system.l1_caches:
+    system.tester.port = cache.cpu_side
+
+system.membus = SystemXBar()
+system.serializing_bus.mem_side = system.membus.cpu_side_ports
+system.system_port = system.membus.cpu_side_ports
+
+system.mem_ctrl = MemCtrl()
+system.mem_ctrl.dram = DDR3_1600_8x8()
+system.mem_ctrl.dram.range = system.mem_ranges[0]
+system.mem_ctrl.port = system.membus.mem_side_ports
+
+root = Root(full_system=False, system=system)
+m5.instantiate()
+
+print(f"Beginning {args.protocol} random coherence test with "
+      f"{args.caches} caches")
+exit_event = m5.simulate()
+print(f"Exiting @ tick {m5.curTick()} because {exit_event.getCause()}")
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Run a grid of cc_config.py points as parallel gem5 processes and collect
+their stats.txt into one CSV.
+
+    ./configs/sweep.py --gem5 ./gem5.opt --jobs 8 \\
+        --param protocol=mesi,dragon,hybrid,adapt \\
+        --param cores=2,4,8 --param block-offset=3,4,5 \\
+        -o sweep.csv -- --cache-size-bit 11 binaries/complex_matrix
+
+Every --param adds one dimension, all combinations are run. Arguments after
+-- are passed to cc_config.py for every point. Each point gets its own gem5
+output directory under --outdir, with the simulator's output in run.log and
+its exit code in exit_code, so points that finished successfully are
+skipped when the sweep is rerun.
+"""
+
+import argparse
+import csv
+import fnmatch
+import itertools
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+DEFAULT_STATS = [
+    'simTicks',
+    'system.serializing_bus.transCount',
+    'system.serializing_bus.rdxCount',
+    'system.serializing_bus.rdCount',
+    'system.serializing_bus.updCount',
+    'system.serializing_bus.rdBytes',
+    'system.serializing_bus.updBytes',
+    'system.serializing_bus.energy.total',
+    'system.l1_caches*.hitCount',
+    'system.l1_caches*.missCount',
+]
+
+
+def parse_param(text):
+    name, values = text.split('=', 1)
+    return name.lstrip('-'), values.split(',')
+
+
+def read_stats(path):
+    """Scalar values of the first stats dump in a stats.txt."""
+    stats = {}
+    with open(path) as f:
+        for line in f:
+            if line.startswith('---------- End'):
+                break
+            fields = line.split()
+            if len(fields) >= 2 and not line.startswith('-'):
+                stats[fields[0]] = fields[1]
+    return stats
+
+
+def read_exit_code(path):
+    """Exit code recorded by an earlier run of a point, None if it has not
+    finished."""
+    try:
+        with open(path) as f:
+            return int(f.read())
+    except (OSError, ValueError):
+        return None
+
+
+def run_point(args, point, extra):
+    name = '_'.join(f'{k}-{v}' for k, v in point)
+    outdir = os.path.join(args.outdir, name)
+    stats_file = os.path.join(outdir, 'stats.txt')
+    # gem5 creates stats.txt when it starts, so only the exit code written
+    # after it returns tells a finished point from a crashed or killed one
+    exit_file = os.path.join(outdir, 'exit_code')
+    if read_exit_code(exit_file) == 0 and not args.force:
+        return point, stats_file, 0
+
+    os.makedirs(outdir, exist_ok=True)
+    if os.path.exists(exit_file):
+        os.remove(exit_file)
+    cmd = [args.gem5, f'--outdir={outdir}', args.config]
+    for key, value in point:
+        cmd += [f'--{key}', value]
+    cmd += extra
+    with open(os.path.join(outdir, 'run.log'), 'w') as log:
+        log.write(' '.join(cmd) + '\n')
+        log.flush()
+        rc = subprocess.call(cmd, stdout=log, stderr=subprocess.STDOUT)
+    with open(exit_file, 'w') as f:
+        f.write(f'{rc}\n')
+    print(f"{'done' if rc == 0 else 'FAILED'}: {name}", file=sys.stderr)
+    return point, stats_file, rc
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--gem5', default='./gem5.opt')
+    parser.add_argument('--config', default='configs/cc_config.py')
+    parser.add_argument('--param', type=parse_param, action='append',
+                        default=[], metavar='NAME=V1,V2,...',
+                        help='cc_config.py option and the values to sweep')
+    parser.add_argument('--stat', action='append', metavar='PATTERN',
+                        help='stat to collect, shell wildcards allowed, '
+                             'may be repeated (default: bus and hit/miss '
+                             'counters, energy and simTicks)')
+    parser.add_argument('--jobs', '-j', type=int, default=os.cpu_count())
+    parser.add_argument('--outdir', default='sweep')
+    parser.add_argument('--force', action='store_true',
+                        help='rerun points that already finished successfully')
+    parser.add_argument('-o', '--output', default='sweep.csv')
+    parser.add_argument('extra', nargs=argparse.REMAINDER,
+                        help='-- followed by arguments for every point')
+    args = parser.parse_args()
+
+    extra = args.extra[1:] if args.extra[:1] == ['--'] else args.extra
+    names = [name for name, _ in args.param]
+    grid = [list(zip(names, values)) for values in
+            itertools.product(*(values for _, values in args.param))]
+
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        results = list(pool.map(lambda p: run_point(args, p, extra), grid))
+
+    patterns = args.stat or DEFAULT_STATS
+    rows = []
+    columns = []
+    for point, stats_file, rc in results:
+        row = dict(point)
+        row['status'] = 'ok' if rc == 0 else f'exit {rc}'
+        if rc == 0 and os.path.exists(stats_file):
+            for stat, value in read_stats(stats_file).items():
+                if any(fnmatch.fnmatchcase(stat, p) for p in patterns):
+                    row[stat] = value
+                    if stat not in columns:
+                        columns.append(stat)
+        rows.append(row)
+
+    with open(args.output, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=names + ['status'] + columns)
+        writer.writeheader()
+        writer.writerows(rows)
+
+    failed = sum(1 for _, _, rc in results if rc != 0)
+    print(f"{len(results)} points, {failed} failed, written to {args.output}",
+          file=sys.stderr)
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Convert binary coherence traces (*.cctrace, written when the bus has
+coherence_trace=True) into one CSV merged in tick order.
+
+    ./cctrace2csv.py m5out/*.cctrace -p hybrid -o trace.csv
+"""
+
+import argparse
+import heapq
+import struct
+import sys
+
+MAGIC = b'CCTRACE\0'
+HEADER = struct.Struct('<8sII')
+# tick, addr, cache id, op, from state, to state, source, bytes
+RECORD = struct.Struct('<QQhBBBBH')
+
+OPS = ['BusRdX', 'BusRd', 'BusUpd', 'BusRdUpd', 'PrRd', 'PrWr', 'Evict',
+       'Flush']
+SOURCES = ['cache', 'bus']
+
+# state enum order of each protocol's coherence state
+STATES = {
+    'mesi': ['I', 'M', 'S', 'E'],
+    'dragon': ['I', 'E', 'M', 'Sc', 'Sm'],
+    'hybrid': ['I', 'E', 'M', 'Sc', 'Sm'],
+    'adapt': ['I', 'E', 'M', 'Sc', 'Sm'],
+}
+
+
+def read_records(path, chunk_records=65536):
+    with open(path, 'rb') as f:
+        magic, version, rec_size = HEADER.unpack(f.read(HEADER.size))
+        if magic != MAGIC or rec_size != RECORD.size:
+            sys.exit(f'{path}: not a coherence trace (version {version})')
+        while True:
+            chunk = f.read(rec_size * chunk_records)
+            if not chunk:
+                break
+            yield from RECORD.iter_unpack(chunk[:len(chunk) -
+                                                len(chunk) % rec_size])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('traces', nargs='+', help='.cctrace files')
+    parser.add_argument('-p', '--protocol', choices=sorted(STATES),
+                        help='print state names instead of enum values')
+    parser.add_argument('-o', '--output', help='CSV file (default stdout)')
+    args = parser.parse_args()
+
+    names = STATES.get(args.protocol)
+
+    def state(val):
+        if names and val < len(names):
+            return names[val]
+        return str(val)
+
+    out = open(args.output, 'w') if args.output else sys.stdout
+    out.write('tick,source,cache,addr,op,from,to,bytes\n')
+    # every file is already in tick order
+    merged = heapq.merge(*(read_records(t) for t in args.traces),
+                         key=lambda r: r[0])
+    for tick, addr, cache, op, frm, to, src, nbytes in merged:
+        # bus records carry no state change
+        frm, to = ('', '') if src else (state(frm), state(to))
+        out.write(f'{tick},{SOURCES[src]},{cache},{addr:#x},{OPS[op]},'
+                  f'{frm},{to},{nbytes}\n')
+    if out is not sys.stdout:
+        out.close()
+
+
+if __name__ == '__main__':
+    main()
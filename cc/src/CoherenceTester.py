@@ -0,0 +1,25 @@
+from m5.params import *
+from m5.proxy import *
+from m5.SimObject import SimObject
+
+
+class CoherenceTester(SimObject):
+    type = 'CoherenceTester'
+    cxx_header = 'src_740/coherence_tester.hh'
+    cxx_class = 'gem5::CoherenceTester'
+
+    port = VectorRequestPort('one port per cache cpu_side')
+    system = Param.System(Parent.any, 'system the tester is part of')
+
+    base_addr = Param.Addr(0x8000, 'address of the first tested block')
+    num_blocks = Param.Unsigned(8, 'number of contended blocks')
+    block_size = Param.Unsigned(32, 'cache block size in bytes')
+    block_stride = Param.Unsigned(32, 'distance between tested blocks, a '
+                                  'multiple of the set span forces evictions')
+    percent_reads = Param.Percent(65, 'percentage of reads')
+
+    interval = Param.Latency('1ns', 'time between issue attempts')
+    max_ops = Param.Counter(0, 'exit after this many checked ops, 0 = never')
+    progress_interval = Param.Counter(100000, 'ops between progress reports')
+    deadlock_threshold = Param.Latency('1ms', 'time without any response '
+                                       'before the tester gives up')
@@ -11,6 +11,14 @@ class CoherentCacheBase(SimObject):
     cpu_side = ResponsePort('CPU side port, receives reqs')
     serializing_bus = Param.SerializingBus('serializing cache coherence bus')
     cache_id = Param.Int(0, 'unique id of private cache in system')
+    response_latency = Param.Latency('1ps', 'delay from a completed '
+                                     'access to the cpu response')
+    cacheable_ranges = VectorParam.AddrRange(
+        [AddrRange(0x8000, 0xa000)], 'address ranges kept coherent, all '
+        'other accesses go straight to memory')
+    store_buffer_entries = Param.Unsigned(0, 'TSO store buffer for stores '
+                                          'to the cacheable ranges, 0 '
+                                          'disables it')
 
 
 class SerializingBus(SimObject):
@@ -20,6 +28,57 @@ class SerializingBus(SimObject):
 
     mem_side = RequestPort('Mem side port, talks to memory')
 
+    grant_latency = Param.Latency('1ps', 'arbitration delay from a bus '
+                                  'request or release to the next grant')
+    request_latency = Param.Latency('1ps', 'delay for a granted request to '
+                                    'be snooped and sent to memory')
+    snoop_retry_latency = Param.Latency('10ns', 'delay before snooping '
+                                        'again when a cluster is busy with '
+                                        'the block')
+
+    # occupancy of a transaction: a command and snoop (tag check) phase,
+    # then ceil(payload / bus_width) data beats for the update, flush and
+    # fill bytes it moves
+    bus_clock = Param.Clock('1GHz', 'bus clock')
+    bus_width = Param.Unsigned(8, 'bytes moved per data beat')
+    arbitration_cycles = Param.Unsigned(1, 'bus cycles from a request or '
+                                        'release to the next grant')
+    snoop_cycles = Param.Unsigned(1, 'bus cycles for the command to be '
+                                  'snooped and tag checked by every cache')
+    beat_cycles = Param.Unsigned(1, 'bus cycles per data beat')
+
+    arbitration_policy = Param.String('fifo', 'who gets the bus next: '
+                                      'fifo, round_robin, fixed_priority '
+                                      '(lowest cache id), age_op or '
+                                      'weighted')
+    arbitration_weights = VectorParam.Unsigned([], 'weighted: grants per '
+                                               'round by cache id, missing '
+                                               'ids weigh 1')
+    arbitration_read_bonus = Param.Latency('20ns', 'age_op: head start of '
+                                           'demand reads over writes and '
+                                           'updates')
+    grant_wait_max = Param.Latency('1us', 'upper end of the per cache '
+                                   'grant wait histograms')
+
+    coherence_trace = Param.Bool(False, 'write a binary coherence event '
+                                 'trace per cache and bus to the outdir')
+    trace_buffer_records = Param.Unsigned(65536, 'trace records buffered '
+                                          'per object between file writes')
+    sharing_profile = Param.Bool(False, 'classify how each block is shared '
+                                 'and write <bus>.sharing.txt at exit')
+
+    # energy model, all in pJ; rough defaults, set them from CACTI and
+    # DRAMPower numbers for the modeled technology
+    energy_bus_rdx = Param.Float(10.0, 'energy per BusRdX transaction')
+    energy_bus_rd = Param.Float(10.0, 'energy per BusRd transaction')
+    energy_bus_upd = Param.Float(10.0, 'energy per BusUpd transaction')
+    energy_bus_rdupd = Param.Float(15.0, 'energy per BusRdUpd transaction')
+    energy_bus_byte = Param.Float(2.0, 'energy per byte moved on the bus')
+    energy_snoop = Param.Float(5.0, 'tag lookup energy per snooping cache')
+    energy_data_read = Param.Float(20.0, 'energy per data array read')
+    energy_data_write = Param.Float(25.0, 'energy per data array write')
+    energy_dram = Param.Float(15000.0, 'energy per DRAM block access')
+
 
 class MiCache(CoherentCacheBase):
     type = 'MiCache'
@@ -50,6 +109,8 @@ class DragonCache(CoherentCacheBase):
     blockOffset = Param.Int(5, 'number of bits for blockOffset')
     setBit = Param.Int(4, 'number of bits for cache set')
     cacheSizeBit = Param.Int(15, 'number of bits for cache size')
+    sectorBit = Param.Int(0, 'log2 of the sectors per block, each sector '
+                          'is kept coherent on its own')
 
 class HybridCache(CoherentCacheBase):
     type = 'HybridCache'
@@ -70,4 +131,40 @@ class AdaptCache(CoherentCacheBase):
     setBit = Param.Int(4, 'number of bits for cache set')
     cacheSizeBit = Param.Int(15, 'number of bits for cache size')
     invalidThreshold = Param.Int(0, 'initial value of invalid threshold')
-    invalidationRatio = Param.Int(2, '(Ci + Cr)/Cu')
\ No newline at end of file
+    invalidationRatio = Param.Int(2, '(Ci + Cr)/Cu')
+
+
+class ClusterCache(CoherentCacheBase):
+    type = 'ClusterCache'
+    cxx_header = 'src_740/cluster_cache.hh'
+    cxx_class = 'gem5::ClusterCache'
+
+    # cpu_side connects to local_bus.mem_side, serializing_bus is the
+    # global bus shared with the other clusters
+    local_bus = Param.SerializingBus('bus of the L1s in this cluster')
+    blockOffset = Param.Int(5, 'log2 of the block size, same as the L1s')
+    setBit = Param.Int(4, 'log2 of the number of sets')
+    cacheSizeBit = Param.Int(15, 'log2 of the cache size')
+
+
+class SharedLLC(SimObject):
+    type = 'SharedLLC'
+    cxx_header = 'src_740/shared_llc.hh'
+    cxx_class = 'gem5::SharedLLC'
+
+    cpu_side = ResponsePort('connects to the mem_side of the bus')
+    mem_side = RequestPort('connects to the memory bus')
+
+    serializing_bus = Param.SerializingBus('bus whose caches it includes, '
+                                           'the block size is the bus\'s')
+    setBit = Param.Int(10, 'log2 of the number of sets')
+    assoc = Param.Int(16, 'ways per set')
+    num_banks = Param.Int(4, 'banks, interleaved by block address')
+    tag_latency = Param.Latency('2ns', 'lookup before a miss is sent to '
+                                'memory')
+    hit_latency = Param.Latency('10ns', 'lookup and data access of a hit')
+    bank_occupancy = Param.Latency('2ns', 'time a bank is busy with one '
+                                   'access')
+    cacheable_ranges = VectorParam.AddrRange(
+        [AddrRange(0x8000, 0xa000)], 'ranges it caches, must be the same as '
+        'the coherent caches\'')
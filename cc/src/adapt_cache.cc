@@ -3,8 +3,6 @@
 #include "debug/CCache.hh"
 #include <iostream>
 #define NOT_EXIST -1
-#define SHARED_MEM_START 0x8000
-#define SHARED_MEM_END 0xa000
 
 namespace gem5 {
 
@@ -50,7 +48,12 @@ AdaptCache::AdaptCache(const AdaptCacheParams& params)
     bus->cacheBlockSize = blockSize;
 
     if(bus->invalidationThs.empty()){
-        bus->invalidationThs.resize((SHARED_MEM_END - SHARED_MEM_START)/blockSize);
+        // one threshold per block of every cacheable range
+        uint64_t numBlocks = 0;
+        for(auto &range : cacheableRanges){
+            numBlocks += ((range.end() - 1) >> blockOffset) - (range.start() >> blockOffset) + 1;
+        }
+        bus->invalidationThs.resize(numBlocks);
         for(auto& T : bus->invalidationThs){
             T = invalidThreshold;
         }
@@ -59,11 +62,17 @@ AdaptCache::AdaptCache(const AdaptCacheParams& params)
 
 
 void AdaptCache::printDataHex(uint8_t* data, int length){
-    DPRINTF(CCache, "DATA: ");
+    // format only when CCache debugging is on, never straight to stdout
+    if (!debug::CCache) {
+        return;
+    }
+    std::string hex;
+    char byteStr[3];
     for(int i = 0; i < length; i++){
-        printf("%02x", data[i]);
+        snprintf(byteStr, sizeof(byteStr), "%02x", data[i]);
+        hex += byteStr;
     }
-    printf("\n");
+    DPRINTF(CCache, "DATA: %s\n", hex);
 }
 
 uint64_t AdaptCache::getTag(long addr){
@@ -86,7 +95,15 @@ uint64_t AdaptCache::constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffse
 }
 
 uint64_t AdaptCache::getBlkNumber(long addr){
-    return (addr >> blockOffset) - (SHARED_MEM_START >> blockOffset);
+    // blocks are numbered across the cacheable ranges in order
+    uint64_t base = 0;
+    for(auto &range : cacheableRanges){
+        if(range.contains(addr)){
+            return base + ((addr >> blockOffset) - (range.start() >> blockOffset));
+        }
+        base += ((range.end() - 1) >> blockOffset) - (range.start() >> blockOffset) + 1;
+    }
+    panic("adapt[%d] %#x is not in a cacheable range", cacheId, addr);
 }
 
 void AdaptCache::endWriteRun(long addr, int& currWriteRun){
@@ -119,6 +136,24 @@ bool AdaptCache::isHit(long addr, int &lineID) {
     return (exist && (AdaptCacheMgr[setID].cacheSet[lineID].cohState != AdaptState::INVALID));
 }
 
+int AdaptCache::getCohState(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return (int)AdaptState::INVALID;
+    }
+    return (int)AdaptCacheMgr[getSet(addr)].cacheSet[lineID].cohState;
+}
+
+int AdaptCache::numCohStates() const {
+    return 5;
+}
+
+std::string AdaptCache::cohStateName(int state) const {
+    // in AdaptState order
+    static const char *names[] = {"I", "E", "M", "Sc", "Sm"};
+    return names[state];
+}
+
 int AdaptCache::allocate(long addr) {
     // assume clk_ptr now points to a empty line
     uint64_t setID = getSet(addr);
@@ -168,6 +203,9 @@ void AdaptCache::evict(long addr) {
             // evict block
             cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
             DPRINTF(CCache, "adapt[%d] replaces set: %d, way: %d, block tag: %#x, for %#x\n\n", cacheId, setID, setMgr.clkPtr, cline.tag, addr);
+            noteTransition(TraceEvict, constructAddr(cline.tag, setID, 0),
+                           (int)cline.cohState, (int)AdaptState::INVALID,
+                           cline.dirty ? blockSize : 0);
             // write back if dirty
             if(cline.dirty){
                 assert(cline.cohState == AdaptState::MODIFIED || cline.cohState == AdaptState::SHARED_MOD);
@@ -227,8 +265,8 @@ void AdaptCache::handleCoherentCpuReq(PacketPtr pkt) {
 
         assert(pkt->needsResponse());
 
-        localStats.hitCount++;
-        DPRINTF(CCache, "adapt[%d] cache hit #%d\n", cacheId, localStats.hitCount);
+        noteHit();
+        DPRINTF(CCache, "adapt[%d] cache hit #%d\n", cacheId, stats.hitCount.value());
 
         if (isRead) {
             // no state change or snoop needed, reply now
@@ -321,12 +359,12 @@ void AdaptCache::handleCoherentCpuReq(PacketPtr pkt) {
         // Cache miss handling 
 
         // stats collection start
-        localStats.missCount++;
+        noteMiss();
 
        // std::cerr << "adapt[" << cacheId << "] " << (isRead ? "read" : "write") 
         //         << " miss for addr " << std::hex << addr << std::dec << "\n";
         DPRINTF(CCache, "adapt[%d] %s miss #%d for addr %#x\n", 
-                cacheId, isRead ? "read" : "write", localStats.missCount, addr);
+                cacheId, isRead ? "read" : "write", stats.missCount.value(), addr);
         
         // For both read and write misses, we need to get bus access
 
@@ -790,4 +828,28 @@ void AdaptCache::handleCoherentSnoopedReq(PacketPtr pkt) {
 
 }
 
+void AdaptCache::handleBackInvalidate(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return;
+    }
+
+    uint64_t setID = getSet(addr);
+    cacheLine &cline = AdaptCacheMgr[setID].cacheSet[lineID];
+    DPRINTF(CCache, "adapt[%d] back invalidate set: %d, way: %d for %#x\n\n", cacheId, setID, lineID, addr);
+    noteTransition(TraceEvict, getBlkAddr(addr), (int)cline.cohState,
+                   (int)AdaptState::INVALID, cline.dirty ? blockSize : 0);
+
+    // the level below gets the latest data before dropping the block
+    if(cline.dirty){
+        writeback(addr, &cline.cacheBlock[0]);
+        cline.dirty = false;
+    }
+
+    // the write run ends with the copy
+    endWriteRun(addr, cline.writeRunCounter);
+
+    cline.cohState = AdaptState::INVALID;
+}
+
 } // namespace gem5
@@ -0,0 +1,103 @@
+#include "src_740/bus_arbiter.hh"
+#include "base/logging.hh"
+
+namespace gem5 {
+
+std::unique_ptr<BusArbiter> BusArbiter::create(const std::string &policy,
+    const std::vector<unsigned> &weights, Tick readBonus) {
+    if (policy == "fifo") {
+        return std::make_unique<FifoArbiter>();
+    } else if (policy == "round_robin") {
+        return std::make_unique<RoundRobinArbiter>();
+    } else if (policy == "fixed_priority") {
+        return std::make_unique<FixedPriorityArbiter>();
+    } else if (policy == "age_op") {
+        return std::make_unique<AgeOpArbiter>(readBonus);
+    } else if (policy == "weighted") {
+        for (unsigned w : weights) {
+            fatal_if(w == 0, "weighted bus arbitration needs weights of "
+                     "at least 1");
+        }
+        return std::make_unique<WeightedArbiter>(weights);
+    }
+    fatal("unknown bus arbitration policy '%s', expected fifo, round_robin, "
+          "fixed_priority, age_op or weighted", policy);
+}
+
+std::list<BusRequest>::iterator
+FifoArbiter::pick(std::list<BusRequest> &queue) {
+    return queue.begin();
+}
+
+std::list<BusRequest>::iterator
+RoundRobinArbiter::pick(std::list<BusRequest> &queue) {
+    // smallest id above lastGranted, else the smallest id
+    auto best = queue.end();
+    auto lowest = queue.begin();
+    for (auto it = queue.begin(); it != queue.end(); it++) {
+        if (it->cacheId < lowest->cacheId) {
+            lowest = it;
+        }
+        if (it->cacheId > lastGranted &&
+            (best == queue.end() || it->cacheId < best->cacheId)) {
+            best = it;
+        }
+    }
+    return best != queue.end() ? best : lowest;
+}
+
+std::list<BusRequest>::iterator
+FixedPriorityArbiter::pick(std::list<BusRequest> &queue) {
+    auto best = queue.begin();
+    for (auto it = queue.begin(); it != queue.end(); it++) {
+        if (it->cacheId < best->cacheId) {
+            best = it;
+        }
+    }
+    return best;
+}
+
+std::list<BusRequest>::iterator
+AgeOpArbiter::pick(std::list<BusRequest> &queue) {
+    // the earliest effective arrival is the oldest, ties go to the queue
+    // order
+    auto best = queue.begin();
+    Tick bestArrival = MaxTick;
+    for (auto it = queue.begin(); it != queue.end(); it++) {
+        Tick arrival = it->arrival;
+        if (it->demandRead) {
+            arrival = arrival > readBonus ? arrival - readBonus : 0;
+        }
+        if (arrival < bestArrival) {
+            best = it;
+            bestArrival = arrival;
+        }
+    }
+    return best;
+}
+
+long WeightedArbiter::weight(int cacheId) const {
+    if (cacheId >= 0 && cacheId < (int)weights.size()) {
+        return weights[cacheId];
+    }
+    return 1;
+}
+
+std::list<BusRequest>::iterator
+WeightedArbiter::pick(std::list<BusRequest> &queue) {
+    auto best = queue.end();
+    long total = 0;
+    for (auto it = queue.begin(); it != queue.end(); it++) {
+        long w = weight(it->cacheId);
+        total += w;
+        long &c = credit[it->cacheId];
+        c += w;
+        if (best == queue.end() || c > credit[best->cacheId]) {
+            best = it;
+        }
+    }
+    credit[best->cacheId] -= total;
+    return best;
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "base/types.hh"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gem5 {
+
+// a cache waiting for the SerializingBus
+struct BusRequest {
+    int cacheId;
+    // tick the cache asked for the bus
+    Tick arrival;
+    // a read the cpu is waiting on, as opposed to a write or an update
+    bool demandRead;
+};
+
+// Picks which waiting cache the bus is granted to next. The bus keeps the
+// queue in arrival order; an arbiter only chooses from it.
+class BusArbiter {
+  public:
+    virtual ~BusArbiter() {}
+
+    // the request to grant, queue is not empty
+    virtual std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) = 0;
+
+    // the picked request was granted
+    virtual void granted(const BusRequest &req) {}
+
+    // policy is one of fifo, round_robin, fixed_priority, age_op or
+    // weighted; weights are per cache id (missing ids weigh 1) and
+    // readBonus is age_op's head start for demand reads
+    static std::unique_ptr<BusArbiter> create(const std::string &policy,
+        const std::vector<unsigned> &weights, Tick readBonus);
+};
+
+// oldest request first
+class FifoArbiter : public BusArbiter {
+  public:
+    std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) override;
+};
+
+// the first waiting cache id after the last one granted, cyclically
+class RoundRobinArbiter : public BusArbiter {
+  public:
+    std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) override;
+    void granted(const BusRequest &req) override { lastGranted = req.cacheId; }
+
+  private:
+    int lastGranted = -1;
+};
+
+// lowest cache id first, may starve the others
+class FixedPriorityArbiter : public BusArbiter {
+  public:
+    std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) override;
+};
+
+// highest age, with demand reads readBonus older than they are; every
+// request keeps aging, so none starves
+class AgeOpArbiter : public BusArbiter {
+  public:
+    AgeOpArbiter(Tick readBonus) : readBonus(readBonus) {}
+
+    std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) override;
+
+  private:
+    Tick readBonus;
+};
+
+// smooth weighted round robin: every pick adds each waiting cache's weight
+// to its credit, the cache with the most credit wins and pays the summed
+// weights of the waiting caches. Over a busy period cache i gets
+// weight[i] / sum(weights) of the grants and waits for at most
+// sum(weights) grants.
+class WeightedArbiter : public BusArbiter {
+  public:
+    WeightedArbiter(const std::vector<unsigned> &weights) : weights(weights) {}
+
+    std::list<BusRequest>::iterator
+    pick(std::list<BusRequest> &queue) override;
+
+  private:
+    std::vector<unsigned> weights;
+    std::unordered_map<int, long> credit;
+
+    long weight(int cacheId) const;
+};
+
+}
@@ -0,0 +1,403 @@
+#include "src_740/cluster_cache.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/CCache.hh"
+#define NOT_EXIST -1
+
+namespace gem5 {
+
+ClusterCache::ClusterCache(const ClusterCacheParams& params)
+    : CoherentCacheBase(params),
+      localBus(params.local_bus),
+      blockOffset(params.blockOffset),
+      setBit(params.setBit),
+      cacheSizeBit(params.cacheSizeBit) {
+    blockSize = 0x1 << blockOffset;
+    numSets = 0x1 << setBit;
+    cacheSize = 0x1 << cacheSizeBit;
+    numLines = cacheSize / numSets / blockSize;
+    fatal_if(numLines < 1, "%s: cache too small for its sets", name());
+
+    ClusterCacheMgr.resize(numSets);
+    for(auto &setMgr : ClusterCacheMgr){
+        setMgr.clkPtr = 0;
+        setMgr.cacheSet.resize(numLines);
+        for(auto &cacheline : setMgr.cacheSet){
+            cacheline.tag = 0;
+            cacheline.clkFlag = 0;
+            cacheline.dirty = false;
+            cacheline.valid = false;
+            cacheline.cohState = ClusterState::Invalid;
+            cacheline.cacheBlock.resize(blockSize);
+        }
+    }
+
+    bus->cacheBlockSize = blockSize;
+    localBus->setCluster(this);
+}
+
+void ClusterCache::init() {
+    CoherentCacheBase::init();
+
+    // the L1s set the local block size when they are constructed
+    fatal_if(localBus->cacheBlockSize != blockSize,
+             "%s: %d byte blocks but the cluster's L1s use %d", name(),
+             blockSize, localBus->cacheBlockSize);
+}
+
+uint64_t ClusterCache::getTag(long addr){
+    return ((uint64_t)addr >> ((blockOffset + setBit)));
+}
+
+uint64_t ClusterCache::getSet(long addr){
+    uint64_t mask = (0x1 << (blockOffset + setBit)) - 1;
+    return ((uint64_t)addr & mask) >> blockOffset;
+}
+
+uint64_t ClusterCache::getBlkAddr(long addr){
+    return ((addr >> blockOffset) << blockOffset);
+}
+
+uint64_t ClusterCache::constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset){
+    return ((tag << (blockOffset+setBit)) | (set << blockOffset)) | blkOffset;
+}
+
+bool ClusterCache::isHit(long addr, int &lineID) {
+    cacheSetMgr &setMgr = ClusterCacheMgr[getSet(addr)];
+    auto it = setMgr.tagMap.find(getTag(addr));
+    if(it == setMgr.tagMap.end()){
+        lineID = NOT_EXIST;
+        return false;
+    }
+    lineID = it->second;
+    return setMgr.cacheSet[lineID].cohState != ClusterState::Invalid;
+}
+
+ClusterCache::cacheLine *ClusterCache::findLine(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return nullptr;
+    }
+    return &ClusterCacheMgr[getSet(addr)].cacheSet[lineID];
+}
+
+int ClusterCache::getCohState(Addr addr) {
+    cacheLine *line = findLine(addr);
+    return line ? (int)line->cohState : (int)ClusterState::Invalid;
+}
+
+int ClusterCache::numCohStates() const {
+    return 4;
+}
+
+std::string ClusterCache::cohStateName(int state) const {
+    // in ClusterState order
+    static const char *names[] = {"I", "M", "S", "E"};
+    return names[state];
+}
+
+int ClusterCache::allocate(long addr) {
+    uint64_t setID = getSet(addr);
+    cacheSetMgr &setMgr = ClusterCacheMgr[setID];
+
+    assert(setMgr.cacheSet[setMgr.clkPtr].valid == false);
+
+    cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
+    cline.dirty = false;
+    cline.clkFlag = 1;
+    cline.cohState = ClusterState::Invalid;
+    cline.valid = true;
+    cline.tag = getTag(addr);
+
+    setMgr.tagMap[cline.tag] = setMgr.clkPtr;
+    int lineID = setMgr.clkPtr;
+    setMgr.clkPtr = (setMgr.clkPtr + 1) % numLines;
+
+    DPRINTF(CCache, "cluster[%d] allocate set: %d, way: %d for %#x\n\n", cacheId, setID, lineID, addr);
+    return lineID;
+}
+
+void ClusterCache::evict(long addr) {
+    uint64_t setID = getSet(addr);
+    cacheSetMgr &setMgr = ClusterCacheMgr[setID];
+
+    if(setMgr.tagMap.size() < numLines){
+        // still have unallocated lines
+        return;
+    }
+
+    while(1){
+        if(setMgr.cacheSet[setMgr.clkPtr].clkFlag == 1){
+            setMgr.cacheSet[setMgr.clkPtr].clkFlag = 0;
+        }
+        else{
+            cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
+            uint64_t victim = constructAddr(cline.tag, setID, 0);
+            DPRINTF(CCache, "cluster[%d] replaces set: %d, way: %d, block %#x, for %#x\n\n", cacheId, setID, setMgr.clkPtr, victim, addr);
+
+            // inclusion: the L1 copies go first, dirty ones flush into
+            // this line on the way out
+            if(cline.cohState != ClusterState::Invalid){
+                localBus->clusterInvalidate(victim);
+            }
+            noteTransition(TraceEvict, victim, (int)cline.cohState,
+                           (int)ClusterState::Invalid,
+                           cline.dirty ? blockSize : 0);
+            if(cline.dirty){
+                bus->sendBlkWriteback(cacheId, victim, &cline.cacheBlock[0], blockSize);
+            }
+
+            setMgr.tagMap.erase(cline.tag);
+            cline.valid = false;
+            break;
+        }
+
+        setMgr.clkPtr = (setMgr.clkPtr+1)%numLines;
+    }
+}
+
+bool ClusterCache::hasPermission(Addr addr, bool isWrite) {
+    if(snoopWaiting && getBlkAddr(addr) == snoopWaitingAddr){
+        // let the retried global snoop through first
+        return false;
+    }
+    cacheLine *line = findLine(addr);
+    if(line == nullptr){
+        return false;
+    }
+    return !isWrite || line->cohState == ClusterState::Exclusive ||
+           line->cohState == ClusterState::Modified;
+}
+
+void ClusterCache::acquire(Addr addr, bool isWrite) {
+    assert(!acquiring && requestPacket == nullptr);
+    acquiring = true;
+    acquireAddr = getBlkAddr(addr);
+    acquireWrite = isWrite;
+    fetched = false;
+    DPRINTF(CCache, "cluster[%d] acquire %#x for %s\n\n", cacheId, acquireAddr, isWrite ? "write" : "read");
+
+    RequestPtr req = std::make_shared<Request>(acquireAddr, blockSize, 0, 0);
+    requestPacket = new Packet(req, isWrite ? MemCmd::WriteReq : MemCmd::ReadReq, blockSize);
+    requestPacket->allocate();
+
+    blocked = true;
+    bus->request(cacheId);
+}
+
+void ClusterCache::lock(Addr addr) {
+    locked = true;
+    lockedAddr = getBlkAddr(addr);
+}
+
+void ClusterCache::unlock() {
+    locked = false;
+}
+
+void ClusterCache::handleCoherentBusGrant() {
+    assert(acquiring);
+    assert(cacheId == bus->currentGranted);
+
+    bus->sharedWire = false;
+
+    int lineID;
+    bool cacheHit = isHit(acquireAddr, lineID);
+    BusOperationType busOp = acquireWrite ? BusRdX : BusRd;
+
+    if(cacheHit && (!acquireWrite ||
+                    getCohState(acquireAddr) != (int)ClusterState::Shared)){
+        // only waited for a retried snoop, the block is still held
+        handleCoherentMemResp(requestPacket);
+        return;
+    }
+
+    if(cacheHit){
+        // Shared to Exclusive, the data is already here
+        DPRINTF(CCache, "cluster[%d] broadcast BusRdX upgrade for %#x\n\n", cacheId, acquireAddr);
+        bus->sendMemReq(requestPacket, false, busOp);
+    }
+    else{
+        DPRINTF(CCache, "cluster[%d] broadcast %s for %#x\n\n", cacheId, acquireWrite ? "BusRdX" : "BusRd", acquireAddr);
+        bus->sendMemReq(requestPacket, true, busOp);
+    }
+
+    busStatsUpdate(busOp, blockSize);
+}
+
+void ClusterCache::handleCoherentMemResp(PacketPtr respPacket) {
+    assert(acquiring && requestPacket != nullptr);
+
+    int lineID;
+    uint64_t setID = getSet(acquireAddr);
+    bool cacheHit = isHit(acquireAddr, lineID);
+    bool memoryFetch = respPacket != requestPacket;
+
+    if(!cacheHit && lineID == NOT_EXIST){
+        evict(acquireAddr);
+        lineID = allocate(acquireAddr);
+    }
+    cacheLine &cline = ClusterCacheMgr[setID].cacheSet[lineID];
+    int fromState = (int)cline.cohState;
+
+    if(memoryFetch){
+        respPacket->writeDataToBlock(&cline.cacheBlock[0], blockSize);
+        cline.dirty = false;
+        delete respPacket;
+        fetched = true;
+        fetchedAddr = acquireAddr;
+    }
+
+    if(acquireWrite){
+        // clean until an L1 flushes into it
+        cline.cohState = cline.dirty ? ClusterState::Modified : ClusterState::Exclusive;
+    }
+    else if(!cacheHit){
+        cline.cohState = bus->sharedWire ? ClusterState::Shared : ClusterState::Exclusive;
+    }
+    bus->sharedWire = false;
+    cline.clkFlag = 1;
+
+    noteTransition(acquireWrite ? TracePrWr : TracePrRd, acquireAddr,
+                   fromState, (int)cline.cohState, blockSize);
+    DPRINTF(CCache, "cluster[%d] acquired %#x in %s\n\n", cacheId, acquireAddr, cohStateName((int)cline.cohState));
+
+    delete requestPacket;
+    requestPacket = nullptr;
+    acquiring = false;
+    blocked = false;
+
+    if(cacheId == bus->currentGranted){
+        bus->release(cacheId);
+    }
+    localBus->clusterAcquired();
+}
+
+void ClusterCache::handleCoherentCpuReq(PacketPtr pkt) {
+    // a block fill for an L1, the local bus made sure the block is here
+    Addr addr = pkt->getAddr();
+    cacheLine *line = findLine(addr);
+    panic_if(line == nullptr, "cluster[%d] local access %#x to a block it "
+             "does not hold", cacheId, addr);
+
+    if(fetched && getBlkAddr(addr) == fetchedAddr){
+        noteMiss();
+        fetched = false;
+    }
+    else{
+        noteHit();
+    }
+
+    line->clkFlag = 1;
+    if(pkt->isRead()){
+        pkt->setDataFromBlock(&line->cacheBlock[0], blockSize);
+    }
+    else{
+        pkt->writeDataToBlock(&line->cacheBlock[0], blockSize);
+        line->dirty = true;
+        line->cohState = ClusterState::Modified;
+    }
+    DPRINTF(CCache, "cluster[%d] local %s %#x\n\n", cacheId, pkt->isRead() ? "fill" : "write", addr);
+
+    if(pkt->needsResponse()){
+        pkt->makeResponse();
+    }
+    sendCpuResp(pkt);
+}
+
+void ClusterCache::handleFunctional(PacketPtr pkt) {
+    // L1 writebacks arrive here as functional writes
+    cacheLine *line = isCacheablePacket(pkt) ? findLine(pkt->getAddr()) : nullptr;
+    if(line == nullptr){
+        bus->sendMemReqFunctional(pkt);
+        return;
+    }
+
+    if(pkt->isWrite()){
+        pkt->writeDataToBlock(&line->cacheBlock[0], blockSize);
+        line->dirty = true;
+        if(line->cohState == ClusterState::Exclusive){
+            line->cohState = ClusterState::Modified;
+        }
+    }
+    else{
+        pkt->setDataFromBlock(&line->cacheBlock[0], blockSize);
+    }
+    if(pkt->needsResponse()){
+        pkt->makeResponse();
+    }
+}
+
+void ClusterCache::handleCoherentSnoopedReq(PacketPtr pkt) {
+    Addr addr = getBlkAddr(pkt->getAddr());
+    BusOperationType opType = bus->getOperationType(pkt);
+    cacheLine *line = findLine(addr);
+
+    if(line == nullptr){
+        DPRINTF(CCache, "cluster[%d] snoop miss! nothing to do\n\n", cacheId);
+        return;
+    }
+
+    if(locked && lockedAddr == addr){
+        // an L1 transaction on the block is in flight, the requester
+        // keeps the global bus and snoops again
+        DPRINTF(CCache, "cluster[%d] snoop %#x retry, local transaction in flight\n\n", cacheId, addr);
+        bus->retryWire = true;
+        snoopWaiting = true;
+        snoopWaitingAddr = addr;
+        return;
+    }
+    if(snoopWaiting && snoopWaitingAddr == addr){
+        snoopWaiting = false;
+    }
+
+    panic_if(bus->hasBusUpd(opType), "cluster[%d] snooped a bus update, "
+             "the global bus only carries BusRd and BusRdX", cacheId);
+
+    if(opType == BusRd){
+        bus->sharedWire = true;
+        if(line->cohState == ClusterState::Shared){
+            return;
+        }
+        // no L1 may keep writing silently, dirty ones flush into the line
+        localBus->clusterDowngrade(addr);
+        line->cohState = ClusterState::Shared;
+        DPRINTF(CCache, "STATE_BusRd: cluster[%d] %#x to Shared\n\n", cacheId, addr);
+    }
+    else{
+        localBus->clusterInvalidate(addr);
+        line->cohState = ClusterState::Invalid;
+        DPRINTF(CCache, "STATE_BusRdX: cluster[%d] %#x to Invalid\n\n", cacheId, addr);
+    }
+
+    if(line->dirty){
+        bus->sendBlkWriteback(cacheId, addr, &line->cacheBlock[0], blockSize);
+        bus->stats.rdBytes += blockSize;
+        line->dirty = false;
+    }
+}
+
+void ClusterCache::handleBackInvalidate(Addr addr) {
+    cacheLine *line = findLine(addr);
+    if(line == nullptr || line->cohState == ClusterState::Invalid){
+        return;
+    }
+
+    DPRINTF(CCache, "cluster[%d] back invalidate %#x\n\n", cacheId, addr);
+    noteTransition(TraceEvict, getBlkAddr(addr), (int)line->cohState,
+                   (int)ClusterState::Invalid, line->dirty ? blockSize : 0);
+
+    // inclusion, the L1 copies go first and flush into this line
+    localBus->clusterInvalidate(addr);
+    if(line->dirty){
+        bus->sendBlkWriteback(cacheId, getBlkAddr(addr), &line->cacheBlock[0], blockSize);
+        line->dirty = false;
+    }
+    line->cohState = ClusterState::Invalid;
+}
+
+bool ClusterCache::canBackInvalidate(Addr addr) {
+    // an L1 is being filled with the block over the local bus
+    return !(locked && lockedAddr == getBlkAddr(addr));
+}
+
+} // namespace gem5
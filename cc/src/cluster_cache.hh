@@ -0,0 +1,112 @@
+#pragma once
+
+#include "mem/port.hh"
+#include "params/ClusterCache.hh"
+#include "sim/sim_object.hh"
+
+#include "src_740/coherent_cache_base.hh"
+#include "src_740/serializing_bus.hh"
+
+#include <vector>
+#include <unordered_map>
+
+namespace gem5 {
+
+// Inclusive cache of a cluster of L1s. Its cpu_side is the memory of the
+// cluster's local SerializingBus, and it is kept coherent with the other
+// clusters over the global bus with MESI. The L1s run their own protocol on
+// the local bus; the local bus only grants a transaction on a block once
+// the cluster holds the block with enough permission (any valid state to
+// read, E or M to write), so sharing inside the cluster never reaches the
+// global bus. Global snoops are forwarded to the L1s as a BusRd (downgrade)
+// or a back invalidation, and are retried while a local transaction on the
+// same block is in flight.
+class ClusterCache : public CoherentCacheBase {
+   public:
+    ClusterCache(const ClusterCacheParams &params);
+
+    // in MesiState order, so the stats read the same
+    enum class ClusterState {
+        Invalid,
+        Modified,
+        Shared,
+        Exclusive
+    };
+
+    typedef struct CacheLine{
+        std::vector<uint8_t> cacheBlock;
+        uint64_t tag;
+        ClusterState cohState;
+        bool dirty;
+        bool clkFlag;
+        // for replacement, same as found in tagMap
+        bool valid;
+    } cacheLine;
+
+    typedef struct CacheSetMgr{
+        std::vector<CacheLine> cacheSet;
+        std::unordered_map<uint64_t, int> tagMap;
+        int clkPtr;
+    } cacheSetMgr;
+
+    // bus of the L1s in this cluster
+    SerializingBus *localBus;
+
+    int blockOffset = 5;
+    int blockSize = 32;
+
+    int setBit = 4;
+    int numSets = 16;
+
+    int cacheSizeBit = 15;
+    int cacheSize = 32 * 1024;
+    int numLines;
+
+    std::vector<cacheSetMgr> ClusterCacheMgr;
+
+    // block being acquired on the global bus for the local bus
+    bool acquiring = false;
+    Addr acquireAddr = 0;
+    bool acquireWrite = false;
+    // block fetched by the last acquisition, its local fill is a miss
+    bool fetched = false;
+    Addr fetchedAddr = 0;
+
+    // block of the local transaction in flight, global snoops to it retry
+    bool locked = false;
+    Addr lockedAddr = 0;
+    // a global snoop is waiting for the locked block, no new local
+    // transaction may start on it until the snoop went through
+    bool snoopWaiting = false;
+    Addr snoopWaitingAddr = 0;
+
+    uint64_t getTag(long addr);
+    uint64_t getSet(long addr);
+    uint64_t getBlkAddr(long addr);
+    uint64_t constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset);
+    bool isHit(long addr, int &lineID);
+    cacheLine *findLine(Addr addr);
+    int allocate(long addr);
+    void evict(long addr);
+
+    // called by the local bus before it grants a local transaction
+    bool hasPermission(Addr addr, bool isWrite);
+    void acquire(Addr addr, bool isWrite);
+    void lock(Addr addr);
+    void unlock();
+
+    void init() override;
+
+    int getCohState(Addr addr) override;
+    int numCohStates() const override;
+    std::string cohStateName(int state) const override;
+
+    void handleFunctional(PacketPtr pkt) override;
+    void handleCoherentCpuReq(PacketPtr pkt) override;
+    void handleCoherentBusGrant() override;
+    void handleCoherentMemResp(PacketPtr pkt) override;
+    void handleCoherentSnoopedReq(PacketPtr pkt) override;
+    void handleBackInvalidate(Addr addr) override;
+    bool canBackInvalidate(Addr addr) override;
+};
+}
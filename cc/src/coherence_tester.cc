@@ -0,0 +1,185 @@
+#include "src_740/coherence_tester.hh"
+
+#include "base/logging.hh"
+#include "base/random.hh"
+#include "base/trace.hh"
+#include "debug/CohTest.hh"
+#include "sim/sim_exit.hh"
+
+#include <cstring>
+
+namespace gem5 {
+
+CoherenceTester::CoherenceTester(const CoherenceTesterParams &params)
+    : SimObject(params),
+      system(params.system),
+      requestorId(params.system->getRequestorId(this)),
+      baseAddr(params.base_addr),
+      numBlocks(params.num_blocks),
+      blockSize(params.block_size),
+      blockStride(params.block_stride),
+      percentReads(params.percent_reads),
+      interval(params.interval),
+      maxOps(params.max_ops),
+      progressInterval(params.progress_interval),
+      deadlockThreshold(params.deadlock_threshold),
+      nextProgress(params.progress_interval),
+      tickEvent([this](){ tick(); }, name() + ".tick"),
+      deadlockEvent([this](){ checkDeadlock(); }, name() + ".deadlock") {
+    fatal_if(numBlocks == 0, "%s needs at least one block", name());
+    fatal_if(blockSize < 4 || blockStride < blockSize,
+             "%s: blocks must hold a 4 byte access and not overlap", name());
+    // the caches only keep 0x8000-0xa000 coherent
+    fatal_if(baseAddr < 0x8000 ||
+             baseAddr + (numBlocks - 1) * blockStride + blockSize > 0xa000,
+             "%s: tested blocks fall outside the cacheable range", name());
+
+    // memory starts out zeroed
+    referenceData.resize((numBlocks - 1) * blockStride + blockSize, 0);
+
+    for (int i = 0; i < params.port_port_connection_count; i++) {
+        ports.emplace_back(new CpuSidePort(
+            name() + ".port" + std::to_string(i), this, i));
+    }
+}
+
+Port& CoherenceTester::getPort(const std::string& port_name, PortID idx) {
+    if (port_name == "port" && idx >= 0 && idx < (PortID)ports.size()) {
+        return *ports[idx];
+    } else {
+        return SimObject::getPort(port_name, idx);
+    }
+}
+
+void CoherenceTester::startup() {
+    schedule(tickEvent, curTick());
+    schedule(deadlockEvent, curTick() + deadlockThreshold);
+}
+
+void CoherenceTester::tick() {
+    if (done) {
+        return;
+    }
+    for (auto &port : ports) {
+        if (!port->busy) {
+            issueRequest(*port);
+        }
+    }
+    schedule(tickEvent, curTick() + interval);
+}
+
+void CoherenceTester::checkDeadlock() {
+    if (done) {
+        return;
+    }
+    panic("%s: no response for %d ticks, %d ops done",
+          name(), deadlockThreshold, numOps());
+}
+
+bool CoherenceTester::issueRequest(CpuSidePort &port) {
+    unsigned size = 1 << random_mt.random<unsigned>(0, 2);
+    unsigned block = random_mt.random<unsigned>(0, numBlocks - 1);
+    unsigned offset = random_mt.random<unsigned>(0, blockSize / size - 1) *
+                      size;
+    Addr addr = baseAddr + block * blockStride + offset;
+    bool isRead = random_mt.random<unsigned>(0, 99) < percentReads;
+
+    // skip this round if another request owns any of the bytes
+    for (unsigned i = 0; i < size; i++) {
+        if (outstandingAddrs.count(addr + i)) {
+            return false;
+        }
+    }
+    for (unsigned i = 0; i < size; i++) {
+        outstandingAddrs.insert(addr + i);
+    }
+
+    RequestPtr req = std::make_shared<Request>(addr, size, 0, requestorId);
+    PacketPtr pkt;
+    if (isRead) {
+        pkt = new Packet(req, MemCmd::ReadReq);
+        pkt->allocate();
+        DPRINTF(CohTest, "port%d read %#x size %d\n", port.portId, addr,
+                size);
+    }
+    else {
+        pkt = new Packet(req, MemCmd::WriteReq);
+        uint8_t *data = new uint8_t[size];
+        for (unsigned i = 0; i < size; i++) {
+            data[i] = random_mt.random<uint8_t>();
+        }
+        pkt->dataDynamic(data);
+        DPRINTF(CohTest, "port%d write %#x size %d\n", port.portId, addr,
+                size);
+    }
+
+    port.busy = true;
+    port.sendPacket(pkt);
+    return true;
+}
+
+void CoherenceTester::completeRequest(CpuSidePort &port, PacketPtr pkt) {
+    assert(port.busy);
+    port.busy = false;
+
+    Addr addr = pkt->getAddr();
+    unsigned size = pkt->getSize();
+    const uint8_t *data = pkt->getConstPtr<uint8_t>();
+    uint8_t *ref = &referenceData[addr - baseAddr];
+
+    if (pkt->isRead()) {
+        for (unsigned i = 0; i < size; i++) {
+            panic_if(data[i] != ref[i],
+                     "%s: port%d read %#x got %#x, expected %#x "
+                     "(op %d)", name(), port.portId, addr + i,
+                     (unsigned)data[i], (unsigned)ref[i], numOps());
+        }
+        numReads++;
+    }
+    else {
+        memcpy(ref, data, size);
+        numWrites++;
+    }
+    DPRINTF(CohTest, "port%d completed %s %#x\n", port.portId,
+            pkt->isRead() ? "read" : "write", addr);
+
+    for (unsigned i = 0; i < size; i++) {
+        outstandingAddrs.erase(addr + i);
+    }
+    delete pkt;
+
+    reschedule(deadlockEvent, curTick() + deadlockThreshold, true);
+
+    if (numOps() >= nextProgress) {
+        inform("%s: %d reads and %d writes checked\n", name(), numReads,
+               numWrites);
+        nextProgress += progressInterval;
+    }
+    if (maxOps != 0 && numOps() >= maxOps && !done) {
+        done = true;
+        exitSimLoop("maximum number of coherence tester ops reached");
+    }
+}
+
+void CoherenceTester::CpuSidePort::sendPacket(PacketPtr pkt) {
+    panic_if(blockedPacket != nullptr, "Should not try to send if blocked!");
+
+    if (!sendTimingReq(pkt)) {
+        blockedPacket = pkt;
+    }
+}
+
+bool CoherenceTester::CpuSidePort::recvTimingResp(PacketPtr pkt) {
+    owner->completeRequest(*this, pkt);
+    return true;
+}
+
+void CoherenceTester::CpuSidePort::recvReqRetry() {
+    assert(blockedPacket != nullptr);
+    PacketPtr pkt = blockedPacket;
+    blockedPacket = nullptr;
+
+    sendPacket(pkt);
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "mem/port.hh"
+#include "params/CoherenceTester.hh"
+#include "sim/sim_object.hh"
+#include "sim/system.hh"
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace gem5 {
+
+// Random stress tester for the coherent caches, in the spirit of MemTest.
+// Each port drives one cache's cpu_side with random 1, 2 and 4 byte reads
+// and writes to a small set of contended blocks. A shadow copy of memory is
+// updated when a write completes and every read response is checked against
+// it. No two outstanding operations touch the same byte, so the expected
+// value of every read is known no matter how the bus orders them.
+class CoherenceTester : public SimObject {
+   public:
+    class CpuSidePort : public RequestPort {
+       public:
+        CoherenceTester *owner;
+        int portId;
+        // request waiting for a retry from the cache
+        PacketPtr blockedPacket = nullptr;
+        // a request is with the cache, the caches take one at a time
+        bool busy = false;
+
+        CpuSidePort(const std::string &name, CoherenceTester *owner,
+                    int portId)
+            : RequestPort(name, owner), owner(owner), portId(portId) {}
+
+        void sendPacket(PacketPtr pkt);
+
+        bool recvTimingResp(PacketPtr pkt) override;
+        void recvReqRetry() override;
+    };
+
+    std::vector<std::unique_ptr<CpuSidePort>> ports;
+
+    System *system;
+    RequestorID requestorId;
+
+    Addr baseAddr;
+    unsigned numBlocks;
+    unsigned blockSize;
+    unsigned blockStride;
+    unsigned percentReads;
+
+    Tick interval;
+    uint64_t maxOps;
+    uint64_t progressInterval;
+    Tick deadlockThreshold;
+
+    // expected memory contents, indexed by offset from baseAddr
+    std::vector<uint8_t> referenceData;
+    // bytes touched by an outstanding request
+    std::unordered_set<Addr> outstandingAddrs;
+
+    uint64_t numReads = 0;
+    uint64_t numWrites = 0;
+    uint64_t nextProgress;
+    bool done = false;
+
+    EventFunctionWrapper tickEvent;
+    EventFunctionWrapper deadlockEvent;
+
+    CoherenceTester(const CoherenceTesterParams &params);
+
+    Port &getPort(const std::string &port_name,
+                  PortID idx = InvalidPortID) override;
+
+    void startup() override;
+
+    void tick();
+    void checkDeadlock();
+    bool issueRequest(CpuSidePort &port);
+    void completeRequest(CpuSidePort &port, PacketPtr pkt);
+
+    uint64_t numOps() const { return numReads + numWrites; }
+};
+
+}
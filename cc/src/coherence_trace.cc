@@ -0,0 +1,45 @@
+#include "src_740/coherence_trace.hh"
+#include "base/logging.hh"
+
+#include <cstring>
+
+namespace gem5 {
+
+// file header: magic, format version and record size
+static const char traceMagic[8] = {'C', 'C', 'T', 'R', 'A', 'C', 'E', '\0'};
+static const uint32_t traceVersion = 1;
+
+void CoherenceTrace::open(const std::string &path, unsigned bufferRecords) {
+    panic_if(file != nullptr, "coherence trace %s opened twice", path);
+    fatal_if(bufferRecords == 0, "coherence trace needs a non-empty buffer");
+
+    file = fopen(path.c_str(), "wb");
+    fatal_if(file == nullptr, "could not open coherence trace %s", path);
+
+    uint32_t recordSize = sizeof(CoherenceTraceRecord);
+    fwrite(traceMagic, sizeof(traceMagic), 1, file);
+    fwrite(&traceVersion, sizeof(traceVersion), 1, file);
+    fwrite(&recordSize, sizeof(recordSize), 1, file);
+
+    buffer.resize(bufferRecords);
+    used = 0;
+}
+
+void CoherenceTrace::flush() {
+    if (file == nullptr || used == 0) {
+        return;
+    }
+    fwrite(buffer.data(), sizeof(CoherenceTraceRecord), used, file);
+    used = 0;
+}
+
+void CoherenceTrace::close() {
+    if (file == nullptr) {
+        return;
+    }
+    flush();
+    fclose(file);
+    file = nullptr;
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "base/types.hh"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace gem5 {
+
+// Op codes stored in a trace record. The first four match BusOperationType
+// so bus ops can be stored without translation.
+enum CoherenceTraceOp : uint8_t {
+    TraceBusRdX = 0,
+    TraceBusRd = 1,
+    TraceBusUpd = 2,
+    TraceBusRdUpd = 3,
+    TracePrRd = 4,      // cpu read completed
+    TracePrWr = 5,      // cpu write completed
+    TraceEvict = 6,     // line replaced
+    TraceFlush = 7      // block written back to memory
+};
+
+// who produced the record
+enum CoherenceTraceSource : uint8_t {
+    TraceFromCache = 0,
+    TraceFromBus = 1
+};
+
+// one fixed size trace record, written to the file as is
+typedef struct CoherenceTraceRecord {
+    uint64_t tick;
+    uint64_t addr;
+    int16_t cacheId;
+    uint8_t op;
+    uint8_t fromState;
+    uint8_t toState;
+    uint8_t source;
+    uint16_t bytes;
+} CoherenceTraceRecord;
+
+static_assert(sizeof(CoherenceTraceRecord) == 24,
+              "trace record layout is read by cc/scripts/cctrace2csv.py");
+
+// Binary event trace owned by a single cache or bus. Records are collected
+// in a preallocated buffer and written out in one fwrite when it fills up,
+// so a disabled trace only costs the enabled() branch at each call site.
+class CoherenceTrace {
+   public:
+    CoherenceTrace() = default;
+    ~CoherenceTrace() { close(); }
+
+    CoherenceTrace(const CoherenceTrace &) = delete;
+    CoherenceTrace &operator=(const CoherenceTrace &) = delete;
+
+    void open(const std::string &path, unsigned bufferRecords);
+    void flush();
+    void close();
+
+    bool enabled() const { return file != nullptr; }
+
+    void record(Tick tick, int cacheId, Addr addr, uint8_t op,
+                uint8_t fromState, uint8_t toState, uint8_t source,
+                unsigned bytes) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        CoherenceTraceRecord &rec = buffer[used++];
+        rec.tick = tick;
+        rec.addr = addr;
+        rec.cacheId = cacheId;
+        rec.op = op;
+        rec.fromState = fromState;
+        rec.toState = toState;
+        rec.source = source;
+        rec.bytes = bytes;
+    }
+
+   private:
+    FILE *file = nullptr;
+    std::vector<CoherenceTraceRecord> buffer;
+    size_t used = 0;
+};
+
+}
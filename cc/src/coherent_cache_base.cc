@@ -1,6 +1,8 @@
 #include "src_740/cache_system.hh"  // Include this file instead of individual headers
+#include "base/output.hh"
 #include "base/trace.hh"
 #include "debug/CCache.hh"
+#include "sim/sim_exit.hh"
 
 namespace gem5 {
 
@@ -10,12 +12,83 @@ CoherentCacheBase::CoherentCacheBase(const CoherentCacheBaseParams& params)
       cacheId(params.cache_id),
       blocked(false),
       bus(params.serializing_bus),
-      cpuRespEvent([this](){ processCpuResp(); }, name()) {}
+      cpuRespEvent([this](){ processCpuResp(); }, name()),
+      responseLatency(params.response_latency),
+      storeBufferEntries(params.store_buffer_entries),
+      stats(this),
+      cacheableRanges(params.cacheable_ranges) {}
+
+CoherentCacheBase::CacheStats::CacheStats(CoherentCacheBase *cache)
+    : statistics::Group(cache),
+      cache(cache),
+      ADD_STAT(hitCount, statistics::units::Count::get(),
+               "number of cpu accesses that hit"),
+      ADD_STAT(missCount, statistics::units::Count::get(),
+               "number of cpu accesses that missed"),
+      ADD_STAT(hitsPerState, statistics::units::Count::get(),
+               "hits by the state of the block at the access"),
+      ADD_STAT(missesPerState, statistics::units::Count::get(),
+               "misses by the state the block was filled in"),
+      ADD_STAT(sbStores, statistics::units::Count::get(),
+               "stores answered by the store buffer"),
+      ADD_STAT(sbForwards, statistics::units::Count::get(),
+               "loads forwarded from the store buffer"),
+      ADD_STAT(sbOccupancy, statistics::units::Count::get(),
+               "average number of stores in the store buffer"),
+      ADD_STAT(sbFullStallTicks, statistics::units::Tick::get(),
+               "ticks cpu stores waited for a full store buffer"),
+      ADD_STAT(sbDrainStallTicks, statistics::units::Tick::get(),
+               "ticks cpu requests waited for the store buffer to drain"),
+      ADD_STAT(busRdXTransitions, statistics::units::Count::get(),
+               "state transitions caused by a snooped BusRdX"),
+      ADD_STAT(busRdTransitions, statistics::units::Count::get(),
+               "state transitions caused by a snooped BusRd"),
+      ADD_STAT(busUpdTransitions, statistics::units::Count::get(),
+               "state transitions caused by a snooped BusUpd"),
+      ADD_STAT(busRdUpdTransitions, statistics::units::Count::get(),
+               "state transitions caused by a snooped BusRdUpd"),
+      ADD_STAT(prRdTransitions, statistics::units::Count::get(),
+               "state transitions caused by a cpu read"),
+      ADD_STAT(prWrTransitions, statistics::units::Count::get(),
+               "state transitions caused by a cpu write"),
+      ADD_STAT(evictTransitions, statistics::units::Count::get(),
+               "state transitions caused by a replacement"),
+      transitions{&busRdXTransitions, &busRdTransitions, &busUpdTransitions,
+                  &busRdUpdTransitions, &prRdTransitions, &prWrTransitions,
+                  &evictTransitions} {}
+
+void CoherentCacheBase::CacheStats::regStats() {
+    statistics::Group::regStats();
+
+    // the protocol is fully constructed by now
+    int numStates = cache->numCohStates();
+
+    hitsPerState.init(numStates);
+    missesPerState.init(numStates);
+    for (int i = 0; i < numStates; i++) {
+        hitsPerState.subname(i, cache->cohStateName(i));
+        missesPerState.subname(i, cache->cohStateName(i));
+    }
+
+    for (auto *matrix : transitions) {
+        matrix->init(numStates, numStates).flags(statistics::nozero);
+        for (int i = 0; i < numStates; i++) {
+            matrix->subname(i, cache->cohStateName(i));
+            matrix->ysubname(i, cache->cohStateName(i));
+        }
+    }
+}
 
 
 void CoherentCacheBase::init() {
     DPRINTF(CCache, "C[%d] registering\n\n", cacheId);
     bus->registerCache(cacheId, this);
+
+    if (bus->traceEnabled) {
+        trace.open(simout.resolve(name() + ".cctrace"),
+                   bus->traceBufferRecords);
+        registerExitCallback([this]() { trace.close(); });
+    }
 }
 
 void CoherentCacheBase::busStatsUpdate(BusOperationType busop, int dataSize){
@@ -44,23 +117,63 @@ void CoherentCacheBase::busStatsUpdate(BusOperationType busop, int dataSize){
             break;
     }
     DPRINTF(CCache, "BUS: total transaction #%d, busrdx: #%d, busrd: #%d, busupd: #%d, read(flush) bytes: %d, update bytes: %d\n\n", 
-        bus->stats.transCount, bus->stats.rdxCount, bus->stats.rdCount, bus->stats.updCount, bus->stats.rdBytes, bus->stats.updBytes);
+        bus->stats.transCount.value(), bus->stats.rdxCount.value(), bus->stats.rdCount.value(),
+        bus->stats.updCount.value(), bus->stats.rdBytes.value(), bus->stats.updBytes.value());
 }
 
 void CoherentCacheBase::processCpuResp() {
-    while(!(cpuRespQueue.size() == 0)) {
-        auto first = cpuRespQueue.begin();
-        auto pkt = *first;
-        cpuRespQueue.erase(first);
+    // drain every response that is ready, stop while the cpu is busy,
+    // recvRespRetry() resumes the drain
+    while(!cpuRespQueue.empty() && cpuRespQueue.front().second <= curTick() &&
+          cpuPort.blockedPacket == nullptr) {
+        PacketPtr pkt = cpuRespQueue.front().first;
+        cpuRespQueue.pop_front();
+        // the cpu got its response when the store entered the buffer
+        if (pkt == drainPacket) {
+            completeDrain();
+            continue;
+        }
         cpuPort.sendPacket(pkt);
         cpuPort.trySendRetry();
     }
+
+    if (!cpuRespQueue.empty() && cpuPort.blockedPacket == nullptr &&
+        !cpuRespEvent.scheduled()) {
+        schedule(cpuRespEvent,
+                 std::max(cpuRespQueue.front().second, curTick()));
+    }
+
+    tryDrain();
 }
 
 
 void CoherentCacheBase::sendCpuResp(PacketPtr pkt) {
-    cpuRespQueue.push_back(pkt);
-    schedule(cpuRespEvent, curTick()+1);
+    Addr addr = pkt->getAddr();
+    int toState = getCohState(addr);
+    noteTransition(pkt->isRead() ? TracePrRd : TracePrWr, addr,
+                   cpuReqState, toState, pkt->getSize());
+    if (cpuReqMiss) {
+        stats.missesPerState[toState]++;
+        cpuReqMiss = false;
+        // the fill
+        bus->energy.dataArrayWrite();
+    }
+    if (pkt->isRead()) {
+        bus->energy.dataArrayRead();
+    }
+    else {
+        bus->energy.dataArrayWrite();
+    }
+    queueCpuResp(pkt);
+}
+
+void CoherentCacheBase::queueCpuResp(PacketPtr pkt) {
+    Tick ready = curTick() + responseLatency;
+    cpuRespQueue.push_back(std::make_pair(pkt, ready));
+    // several responses ready in the same tick share one event
+    if (!cpuRespEvent.scheduled() && cpuPort.blockedPacket == nullptr) {
+        schedule(cpuRespEvent, ready);
+    }
 }
 
 
@@ -85,20 +198,49 @@ void CoherentCacheBase::handleFunctional(PacketPtr pkt) {
 
 void CoherentCacheBase::sendRangeChange() { cpuPort.sendRangeChange(); }
 
+bool CoherentCacheBase::isCacheableAddr(Addr addr) const {
+    for (auto &range : cacheableRanges) {
+        if (range.contains(addr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool CoherentCacheBase::isCacheablePacket(PacketPtr pkt) {
-    auto addr = pkt->getAddr();
-    return (addr >= 0x8000 && addr < 0xa000);
+    return isCacheableAddr(pkt->getAddr());
 }
 
 bool CoherentCacheBase::handleRequest(PacketPtr pkt) {
+    if (storeBufferEntries > 0 && isCacheablePacket(pkt)) {
+        if (handleStoreBufferReq(pkt)) {
+            return true;
+        }
+        // held back until the buffer has room or has drained
+        if (sbStallStart != MaxTick) {
+            return false;
+        }
+    }
+
     if (blocked) {
         DPRINTF(CCache, "request %#x blocked!\n", pkt->getAddr());
         return false;
     }
 
+    startRequest(pkt);
+    return true;
+}
+
+void CoherentCacheBase::startRequest(PacketPtr pkt) {
     // is packet in cacheable range?
     if (isCacheablePacket(pkt)) {
-            handleCoherentCpuReq(pkt);
+        cpuReqState = getCohState(pkt->getAddr());
+        cpuReqMiss = false;
+        if (bus->profileEnabled) {
+            bus->profiler.recordAccess(cacheId, pkt->getAddr(),
+                                       pkt->getSize(), pkt->isWrite());
+        }
+        handleCoherentCpuReq(pkt);
     }
     else {
         blocked = true;
@@ -106,8 +248,116 @@ bool CoherentCacheBase::handleRequest(PacketPtr pkt) {
         // request the bus
         bus->request(cacheId);
     }
+}
 
-    return true;
+bool CoherentCacheBase::handleStoreBufferReq(PacketPtr pkt) {
+    bool atomic = pkt->isLLSC() || pkt->isAtomicOp() ||
+                  (pkt->isRead() && pkt->isWrite());
+
+    if (pkt->isWrite() && !atomic) {
+        if (storeBuffer.size() >= storeBufferEntries) {
+            stallStoreBuffer(true);
+            return false;
+        }
+        endStoreBufferStall();
+
+        // the buffer keeps its own copy, the cpu frees its packet with
+        // the response
+        RequestPtr req = std::make_shared<Request>(pkt->getAddr(),
+                                                   pkt->getSize(), 0, 0);
+        PacketPtr store = new Packet(req, MemCmd::WriteReq);
+        store->allocate();
+        store->setData(pkt->getConstPtr<uint8_t>());
+        storeBuffer.push_back(store);
+        stats.sbStores++;
+        stats.sbOccupancy = storeBuffer.size();
+        DPRINTF(CCache, "C[%d] store %#x buffered, %d in buffer\n\n",
+                cacheId, pkt->getAddr(), storeBuffer.size());
+
+        pkt->makeResponse();
+        queueCpuResp(pkt);
+        tryDrain();
+        return true;
+    }
+
+    if (atomic) {
+        // atomics are ordered after every buffered store
+        if (!storeBuffer.empty()) {
+            stallStoreBuffer(false);
+            return false;
+        }
+        endStoreBufferStall();
+        return false;
+    }
+
+    // a load may pass older stores to other bytes, the youngest store it
+    // overlaps supplies its data
+    Addr addr = pkt->getAddr();
+    for (auto it = storeBuffer.rbegin(); it != storeBuffer.rend(); it++) {
+        PacketPtr store = *it;
+        Addr storeAddr = store->getAddr();
+        if (addr + pkt->getSize() <= storeAddr ||
+            storeAddr + store->getSize() <= addr) {
+            continue;
+        }
+        if (addr < storeAddr ||
+            addr + pkt->getSize() > storeAddr + store->getSize()) {
+            // partly covered, wait until it is in the cache
+            stallStoreBuffer(false);
+            return false;
+        }
+
+        endStoreBufferStall();
+        stats.sbForwards++;
+        pkt->makeResponse();
+        pkt->setData(store->getConstPtr<uint8_t>() + (addr - storeAddr));
+        queueCpuResp(pkt);
+        return true;
+    }
+
+    endStoreBufferStall();
+    return false;
+}
+
+void CoherentCacheBase::stallStoreBuffer(bool full) {
+    if (sbStallStart == MaxTick) {
+        sbStallStart = curTick();
+        sbStallFull = full;
+    }
+}
+
+void CoherentCacheBase::endStoreBufferStall() {
+    if (sbStallStart == MaxTick) {
+        return;
+    }
+    if (sbStallFull) {
+        stats.sbFullStallTicks += curTick() - sbStallStart;
+    }
+    else {
+        stats.sbDrainStallTicks += curTick() - sbStallStart;
+    }
+    sbStallStart = MaxTick;
+}
+
+void CoherentCacheBase::tryDrain() {
+    if (blocked || drainPacket != nullptr || storeBuffer.empty()) {
+        return;
+    }
+    drainPacket = storeBuffer.front();
+    DPRINTF(CCache, "C[%d] draining store %#x\n\n", cacheId,
+            drainPacket->getAddr());
+    startRequest(drainPacket);
+}
+
+void CoherentCacheBase::completeDrain() {
+    assert(drainPacket == storeBuffer.front());
+    storeBuffer.pop_front();
+    stats.sbOccupancy = storeBuffer.size();
+    delete drainPacket;
+    drainPacket = nullptr;
+
+    // the cpu may be waiting for room or for the buffer to drain
+    cpuPort.trySendRetry();
 }
 
 bool CoherentCacheBase::handleResponse(PacketPtr pkt) {
@@ -118,8 +368,11 @@ bool CoherentCacheBase::handleResponse(PacketPtr pkt) {
     } else {
         blocked = false;
         bus->release(cacheId);
-        cpuPort.sendPacket(pkt);
+        // respond behind any store acks still queued, and restart the
+        // drain of stores buffered meanwhile
+        queueCpuResp(pkt);
         cpuPort.trySendRetry();
+        tryDrain();
     }
 
     return true;
@@ -156,6 +409,9 @@ void CoherentCacheBase::CpuSidePort::recvRespRetry() {
     blockedPacket = nullptr;
 
     sendPacket(pkt);
+    if (blockedPacket == nullptr) {
+        owner->processCpuResp();
+    }
 }
 
 void CoherentCacheBase::CpuSidePort::trySendRetry() {
@@ -167,7 +423,18 @@ void CoherentCacheBase::CpuSidePort::trySendRetry() {
 
 void CoherentCacheBase::handleSnoopedReq(PacketPtr pkt) {
     if (isCacheablePacket(pkt)) {
+        Addr addr = pkt->getAddr();
+        BusOperationType op = bus->getOperationType(pkt);
+        int fromState = getCohState(addr);
         handleCoherentSnoopedReq(pkt);
+        int toState = getCohState(addr);
+        noteTransition(op, addr, fromState, toState, pkt->getSize());
+
+        bus->energy.snoopLookup();
+        // a sharer that stays valid takes the update into its data array
+        if (bus->hasBusUpd(op) && fromState != 0 && toState != 0) {
+            bus->energy.dataArrayWrite();
+        }
     }
 }
 
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "base/statistics.hh"
 #include "mem/port.hh"
 #include "params/CoherentCacheBase.hh"
 #include "sim/sim_object.hh"
 
+#include "src_740/coherence_trace.hh"
 #include "src_740/serializing_bus.hh"
 
 #include <list>
+#include <vector>
 
 namespace gem5 {
 
@@ -33,13 +36,44 @@ class CoherentCacheBase : public SimObject {
         void recvRespRetry() override;
     };
 
-    typedef struct CACHEStats{
-        int missCount;
-        int hitCount;
-    } CacheStats;
-
-    // cache stats struct for all caches
-    CacheStats localStats = {0, 0};
+    // causes of a coherence state transition, in CoherenceTraceOp order
+    static const int numTransitionCauses = TraceEvict + 1;
+
+    // cache stats for all caches, sized by the protocol's states in regStats
+    struct CacheStats : public statistics::Group {
+        CacheStats(CoherentCacheBase *cache);
+        void regStats() override;
+
+        CoherentCacheBase *cache;
+
+        statistics::Scalar hitCount;
+        statistics::Scalar missCount;
+        // hits by the state of the block when the cpu access arrived
+        statistics::Vector hitsPerState;
+        // misses by the state the block was filled in
+        statistics::Vector missesPerState;
+
+        // store buffer, only used when store_buffer_entries is set
+        statistics::Scalar sbStores;
+        statistics::Scalar sbForwards;
+        statistics::Average sbOccupancy;
+        // ticks a cpu request waited because the buffer was full, or for
+        // the buffer to drain (atomics, loads partly covered by a store)
+        statistics::Scalar sbFullStallTicks;
+        statistics::Scalar sbDrainStallTicks;
+
+        // from state x to state matrices, one per cause
+        statistics::Vector2d busRdXTransitions;
+        statistics::Vector2d busRdTransitions;
+        statistics::Vector2d busUpdTransitions;
+        statistics::Vector2d busRdUpdTransitions;
+        statistics::Vector2d prRdTransitions;
+        statistics::Vector2d prWrTransitions;
+        statistics::Vector2d evictTransitions;
+
+        // the matrices above indexed by cause
+        statistics::Vector2d *transitions[numTransitionCauses];
+    };
 
     CpuSidePort cpuPort;
 
@@ -49,14 +83,45 @@ class CoherentCacheBase : public SimObject {
     // bus connected to other caches and memory
     SerializingBus* bus;
 
-    // send CPU responses asynchronously
-    std::list<PacketPtr> cpuRespQueue;
+    // send CPU responses asynchronously, each after responseLatency
+    // (packet, tick it is ready to be sent)
+    std::list<std::pair<PacketPtr, Tick>> cpuRespQueue;
     EventFunctionWrapper cpuRespEvent;
+    Tick responseLatency;
     void processCpuResp();
     void sendCpuResp(PacketPtr pkt);
+    void queueCpuResp(PacketPtr pkt);
 
     PacketPtr requestPacket = nullptr;
 
+    // binary event trace, opened in init() when the bus enables tracing
+    CoherenceTrace trace;
+    // TSO store buffer: plain stores to cacheable ranges are answered when
+    // they enter it and drain into the cache in order while it is idle,
+    // loads are forwarded from the youngest store covering them
+    unsigned storeBufferEntries;
+    std::list<PacketPtr> storeBuffer;
+    // the buffer head while it is being written into the cache
+    PacketPtr drainPacket = nullptr;
+    // tick the buffer started holding back a cpu request, and why
+    Tick sbStallStart = MaxTick;
+    bool sbStallFull = false;
+
+    // true if the buffer took the request, false to pass it on or, with
+    // sbStallStart set, to hold it back
+    bool handleStoreBufferReq(PacketPtr pkt);
+    void stallStoreBuffer(bool full);
+    void endStoreBufferStall();
+    void tryDrain();
+    void completeDrain();
+
+    // state of the requested block when the current cpu request arrived
+    int cpuReqState = 0;
+    // the current cpu request missed
+    bool cpuReqMiss = false;
+
+    CacheStats stats;
+
     CoherentCacheBase(const CoherentCacheBaseParams &params);
 
     Port &getPort(const std::string &port_name,
@@ -69,9 +134,13 @@ class CoherentCacheBase : public SimObject {
 
 
     bool handleRequest(PacketPtr pkt);
+    void startRequest(PacketPtr pkt);
     bool handleResponse(PacketPtr pkt);
-    void handleFunctional(PacketPtr pkt);
+    virtual void handleFunctional(PacketPtr pkt);
 
+    // ranges kept coherent, everything else is passed through to memory
+    std::vector<AddrRange> cacheableRanges;
+    bool isCacheableAddr(Addr addr) const;
     bool isCacheablePacket(PacketPtr pkt);
 
     void handleBusGrant();
@@ -82,8 +151,48 @@ class CoherentCacheBase : public SimObject {
     virtual void handleCoherentMemResp(PacketPtr pkt);
     virtual void handleCoherentSnoopedReq(PacketPtr pkt);
 
+    // drop the block for the level below (a cluster cache), writing it
+    // back through the bus first if it is dirty
+    virtual void handleBackInvalidate(Addr addr) {}
+    // false while the block is in use in a way a back invalidation would
+    // break, the shared LLC then replaces another block
+    virtual bool canBackInvalidate(Addr addr) { return true; }
+
     void busStatsUpdate(BusOperationType busop, int dataSize);
 
+    // coherence state of the block holding addr as a protocol enum value,
+    // 0 (invalid in every protocol) if the block is not cached
+    virtual int getCohState(Addr addr) { return 0; }
+
+    // number of protocol states and their names for the stats
+    virtual int numCohStates() const { return 1; }
+    virtual std::string cohStateName(int state) const { return "I"; }
+
+    void noteHit() {
+        stats.hitCount++;
+        stats.hitsPerState[cpuReqState]++;
+    }
+
+    void noteMiss() {
+        stats.missCount++;
+        cpuReqMiss = true;
+    }
+
+    // record a state transition in the stats and the event trace
+    void noteTransition(uint8_t cause, Addr addr, int fromState, int toState,
+                        unsigned bytes) {
+        (*stats.transitions[cause])[fromState][toState]++;
+        traceTransition(cause, addr, fromState, toState, bytes);
+    }
+
+    void traceTransition(uint8_t op, Addr addr, int fromState, int toState,
+                         unsigned bytes) {
+        if (trace.enabled()) {
+            trace.record(curTick(), cacheId, addr, op, fromState, toState,
+                         TraceFromCache, bytes);
+        }
+    }
+
     virtual ~CoherentCacheBase() {}
 };
 }
\ No newline at end of file
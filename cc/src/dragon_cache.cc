@@ -10,7 +10,9 @@ DragonCache::DragonCache(const DragonCacheParams& params)
     : CoherentCacheBase(params),
     blockOffset(params.blockOffset),
     setBit(params.setBit),
-    cacheSizeBit(params.cacheSizeBit) {
+    cacheSizeBit(params.cacheSizeBit),
+    sectorBit(params.sectorBit),
+    sectorStats(this) {
     std::cerr << "Dragon Cache " << cacheId << " created\n";
     DPRINTF(CCache, "Dragon[%d] cache created\n", cacheId);
 
@@ -19,6 +21,13 @@ DragonCache::DragonCache(const DragonCacheParams& params)
     numSets = 0x1 << setBit;
     cacheSize = 0x1 << cacheSizeBit;
     numLines =  cacheSize / numSets / blockSize;
+    numSectors = 0x1 << sectorBit;
+    sectorSize = blockSize >> sectorBit;
+    // the cpu issues aligned accesses of up to 8 bytes, each has to fit in
+    // one sector
+    fatal_if(sectorSize < 8, "dragon[%d]: sectorBit %d leaves %d-byte "
+             "sectors, at least 8 are needed", cacheId, sectorBit,
+             sectorSize);
 
     DPRINTF(CCache, "blocksize: %d, setsize: %d, cachsize: %d\n\n", blockSize, numLines, cacheSize);
     // init cache manager
@@ -32,25 +41,58 @@ DragonCache::DragonCache(const DragonCacheParams& params)
         for(auto &cacheline : setMgr.cacheSet){
             cacheline.tag = 0;
             cacheline.clkFlag = 0;
-            cacheline.dirty = 0;
             cacheline.valid = false;
-            cacheline.cohState = DragonState::INVALID;
+            cacheline.sectors.resize(numSectors,
+                                     Sector{DragonState::INVALID, false});
             cacheline.cacheBlock.resize(blockSize);
         }
     }
 
     dataToWrite.resize(blockSize);
 
-    bus->cacheBlockSize = blockSize;
+    // the bus fills, snoops and writes back sectors
+    bus->cacheBlockSize = sectorSize;
+}
+
+DragonCache::SectorStats::SectorStats(DragonCache *cache)
+    : statistics::Group(cache, "sectors"),
+      cache(cache),
+      ADD_STAT(hits, statistics::units::Count::get(),
+               "cpu accesses that hit, by sector"),
+      ADD_STAT(misses, statistics::units::Count::get(),
+               "cpu accesses that missed, by sector"),
+      ADD_STAT(transactions, statistics::units::Count::get(),
+               "bus transactions issued, by sector"),
+      ADD_STAT(tagHitMisses, statistics::units::Count::get(),
+               "misses to an invalid sector of a present block") {}
+
+void DragonCache::SectorStats::regStats() {
+    statistics::Group::regStats();
+
+    hits.init(cache->numSectors);
+    misses.init(cache->numSectors);
+    transactions.init(cache->numSectors);
+    for (int i = 0; i < cache->numSectors; i++) {
+        std::string name = "s" + std::to_string(i);
+        hits.subname(i, name);
+        misses.subname(i, name);
+        transactions.subname(i, name);
+    }
 }
 
 
 void DragonCache::printDataHex(uint8_t* data, int length){
-    DPRINTF(CCache, "DATA: ");
+    // format only when CCache debugging is on, never straight to stdout
+    if (!debug::CCache) {
+        return;
+    }
+    std::string hex;
+    char byteStr[3];
     for(int i = 0; i < length; i++){
-        printf("%02x", data[i]);
+        snprintf(byteStr, sizeof(byteStr), "%02x", data[i]);
+        hex += byteStr;
     }
-    printf("\n");
+    DPRINTF(CCache, "DATA: %s\n", hex);
 }
 
 uint64_t DragonCache::getTag(long addr){
@@ -66,6 +108,14 @@ uint64_t DragonCache::getBlkAddr(long addr){
     return ((addr >> blockOffset) << blockOffset);
 }
 
+int DragonCache::getSector(long addr){
+    return ((uint64_t)addr & (blockSize - 1)) / sectorSize;
+}
+
+uint64_t DragonCache::getSectorAddr(long addr){
+    return (uint64_t)addr & ~(uint64_t)(sectorSize - 1);
+}
+
 uint64_t DragonCache::constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset){
  
     return ((tag << (blockOffset+setBit)) | (set << blockOffset)) | blkOffset;
@@ -87,7 +137,25 @@ bool DragonCache::isHit(long addr, int &lineID) {
         lineID = NOT_EXIST;
     }
 
-    return (exist && (DragonCacheMgr[setID].cacheSet[lineID].cohState != DragonState::INVALID));
+    return (exist && (DragonCacheMgr[setID].cacheSet[lineID].sectors[getSector(addr)].cohState != DragonState::INVALID));
+}
+
+int DragonCache::getCohState(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return (int)DragonState::INVALID;
+    }
+    return (int)DragonCacheMgr[getSet(addr)].cacheSet[lineID].sectors[getSector(addr)].cohState;
+}
+
+int DragonCache::numCohStates() const {
+    return 5;
+}
+
+std::string DragonCache::cohStateName(int state) const {
+    // in DragonState order
+    static const char *names[] = {"I", "E", "M", "Sc", "Sm"};
+    return names[state];
 }
 
 int DragonCache::allocate(long addr) {
@@ -100,9 +168,11 @@ int DragonCache::allocate(long addr) {
     assert(setMgr.cacheSet[setMgr.clkPtr].valid == false);
 
     cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
-    cline.dirty = false;
     cline.clkFlag = 1;
-    cline.cohState = DragonState::INVALID;
+    for(auto &sec : cline.sectors){
+        sec.cohState = DragonState::INVALID;
+        sec.dirty = false;
+    }
     cline.valid = true;
     cline.tag = tag;
     memset(&cline.cacheBlock[0], 0, blockSize);
@@ -137,11 +207,20 @@ void DragonCache::evict(long addr) {
             // evict block
             cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
             DPRINTF(CCache, "dragon[%d] replaces set: %d, way: %d, block tag: %#x, for %#x\n\n", cacheId, setID, setMgr.clkPtr, cline.tag, addr);
-            // write back if dirty
-            if(cline.dirty){
-                assert(cline.cohState == DragonState::MODIFIED || cline.cohState == DragonState::SHARED_MOD);
-                uint64_t wbAddr = constructAddr(cline.tag, setID, 0);
-                writeback(wbAddr, &cline.cacheBlock[0]);
+            for(int i = 0; i < numSectors; i++){
+                Sector &sec = cline.sectors[i];
+                uint64_t secAddr = constructAddr(cline.tag, setID, i * sectorSize);
+                if(sec.cohState == DragonState::INVALID){
+                    continue;
+                }
+                noteTransition(TraceEvict, secAddr, (int)sec.cohState,
+                               (int)DragonState::INVALID,
+                               sec.dirty ? sectorSize : 0);
+                // write back if dirty
+                if(sec.dirty){
+                    assert(sec.cohState == DragonState::MODIFIED || sec.cohState == DragonState::SHARED_MOD);
+                    writeback(secAddr, &cline.cacheBlock[0]);
+                }
             }
 
             // need to erase from map
@@ -159,11 +238,13 @@ void DragonCache::evict(long addr) {
 }
 
 void DragonCache::writeback(long addr, uint8_t* data){ 
+    // data is the whole block, only the sector of addr goes out
+    uint64_t secAddr = getSectorAddr(addr);
+    data += secAddr - getBlkAddr(addr);
+    bus->sendBlkWriteback(cacheId, secAddr, data, sectorSize);
     
-    bus->sendBlkWriteback(cacheId, getBlkAddr(addr), data, blockSize);
-    
-    DPRINTF(CCache, "dragon[%d] writeback %#x with DATA\n\n", cacheId, addr);
-    printDataHex(data, blockSize);
+    DPRINTF(CCache, "dragon[%d] writeback %#x with DATA\n\n", cacheId, secAddr);
+    printDataHex(data, sectorSize);
 }
 
 void DragonCache::handleCoherentCpuReq(PacketPtr pkt) {
@@ -181,18 +262,25 @@ void DragonCache::handleCoherentCpuReq(PacketPtr pkt) {
     uint64_t setID = getSet(addr);
     uint64_t tag = getTag(addr);
     bool cacheHit = isHit(addr, lineID);
+    int sectorID = getSector(addr);
+
+    panic_if(getSector(addr + pkt->getSize() - 1) != sectorID,
+             "dragon[%d] access %#x size %d crosses a sector", cacheId, addr,
+             pkt->getSize());
     
     
     if (cacheHit) {
         // Cache hit
         cacheLine &currCacheline = DragonCacheMgr[setID].cacheSet[lineID];
+        Sector &currSector = currCacheline.sectors[sectorID];
         
-        assert(currCacheline.cohState != DragonState::INVALID);
+        assert(currSector.cohState != DragonState::INVALID);
 
         assert(pkt->needsResponse());
 
-        localStats.hitCount++;
-        DPRINTF(CCache, "dragon[%d] cache hit #%d\n", cacheId, localStats.hitCount);
+        noteHit();
+        sectorStats.hits[sectorID]++;
+        DPRINTF(CCache, "dragon[%d] cache hit #%d\n", cacheId, stats.hitCount.value());
 
         if (isRead) {
             // no state change or snoop needed, reply now
@@ -213,17 +301,17 @@ void DragonCache::handleCoherentCpuReq(PacketPtr pkt) {
 
         } else if (isWrite) {
             // Write hit
-            // std::cerr << "dragon[" << cacheId << "] write hit in state " << " (" << getStateName(currCacheline.cohState) << ")\n";
-            DPRINTF(CCache, "dragon[%d] write hit in state %d\n", cacheId, (int)currCacheline.cohState);
+            // std::cerr << "dragon[" << cacheId << "] write hit in state " << " (" << getStateName(currSector.cohState) << ")\n";
+            DPRINTF(CCache, "dragon[%d] write hit in state %d\n", cacheId, (int)currSector.cohState);
             
-            switch (currCacheline.cohState) {
+            switch (currSector.cohState) {
                 case DragonState::EXCLUSIVE:
                     // E → M on write (PrWr) - no changes needed
                     // std::cerr << "dragon[" << cacheId << "] E→M transition with PrWr\n";
                     DPRINTF(CCache, "STATE_PrWr: dragon[%d] upgrade from Exclusive to Modified for addr %#x\n", cacheId, addr);
-                    currCacheline.cohState = DragonState::MODIFIED;
+                    currSector.cohState = DragonState::MODIFIED;
                     pkt->writeDataToBlock(&currCacheline.cacheBlock[0], blockSize);
-                    currCacheline.dirty = true;
+                    currSector.dirty = true;
                     currCacheline.clkFlag = 1;
     
                     pkt->makeResponse();
@@ -241,7 +329,7 @@ void DragonCache::handleCoherentCpuReq(PacketPtr pkt) {
                     DPRINTF(CCache, "STATE_PrWr: dragon[%d] stay in Modified for addr %#x\n", cacheId, addr);
 
                     pkt->writeDataToBlock(&currCacheline.cacheBlock[0], blockSize);
-                    assert(currCacheline.dirty == true);
+                    assert(currSector.dirty == true);
                     currCacheline.clkFlag = 1;
     
                     pkt->makeResponse();
@@ -279,12 +367,16 @@ void DragonCache::handleCoherentCpuReq(PacketPtr pkt) {
         // Cache miss handling 
 
         // stats collection start
-        localStats.missCount++;
+        noteMiss();
+        sectorStats.misses[sectorID]++;
+        if(lineID != NOT_EXIST){
+            sectorStats.tagHitMisses++;
+        }
 
        // std::cerr << "dragon[" << cacheId << "] " << (isRead ? "read" : "write") 
         //         << " miss for addr " << std::hex << addr << std::dec << "\n";
         DPRINTF(CCache, "dragon[%d] %s miss #%d for addr %#x\n", 
-                cacheId, isRead ? "read" : "write", localStats.missCount, addr);
+                cacheId, isRead ? "read" : "write", stats.missCount.value(), addr);
         
         // For both read and write misses, we need to get bus access
 
@@ -315,7 +407,7 @@ void DragonCache::handleCoherentBusGrant() {
     DPRINTF(CCache, "dragon[%d] bus granted\n\n", cacheId);
     
     uint64_t addr = requestPacket->getAddr();
-    uint64_t blk_addr = requestPacket->getBlockAddr(blockSize);
+    uint64_t sector_addr = getSectorAddr(addr);
     uint64_t size = requestPacket->getSize();
 
     int lineID;
@@ -332,12 +424,12 @@ void DragonCache::handleCoherentBusGrant() {
     bus->sharedWire = false;
 
     if (cacheHit) {
-        cacheLine &currCacheline = DragonCacheMgr[setID].cacheSet[lineID];
-        assert(isWrite && (currCacheline.cohState == DragonState::SHARED_CLEAN || currCacheline.cohState == DragonState::SHARED_MOD));
+        Sector &currSector = DragonCacheMgr[setID].cacheSet[lineID].sectors[getSector(addr)];
+        assert(isWrite && (currSector.cohState == DragonState::SHARED_CLEAN || currSector.cohState == DragonState::SHARED_MOD));
         // We had a hit but needed the bus (e.g., for write to shared line)
 
         busOp = BusUpd;
-        if (currCacheline.cohState == DragonState::SHARED_CLEAN) {
+        if (currSector.cohState == DragonState::SHARED_CLEAN) {
             // Sc → Sm transition via PrWr(S')
             // std::cerr << "dragon[" << cacheId << "] in Sc broadcast BudUpd on write\n";
             DPRINTF(CCache, "dragon[%d] in Sc broadcast BusUpd on write for addr %#x\n", 
@@ -347,7 +439,7 @@ void DragonCache::handleCoherentBusGrant() {
             bus->sendMemReq(requestPacket, false, BusUpd);
             
         }
-        else if (currCacheline.cohState == DragonState::SHARED_MOD) {
+        else if (currSector.cohState == DragonState::SHARED_MOD) {
             // std::cerr << "dragon[" << cacheId << "] in Sm broadcast BudUpd on write\n";
             DPRINTF(CCache, "dragon[%d] in Sm broadcast BusUpd on write for addr %#x\n", 
                     cacheId, addr);
@@ -379,8 +471,8 @@ void DragonCache::handleCoherentBusGrant() {
             busOp = BusRdUpd;
             
             // This will be handled in handleCoherentMemResp
-            if(addr == blk_addr && size == blockSize){
-                // overwrite whole block
+            if(addr == sector_addr && size == sectorSize){
+                // overwrite whole sector
                 bus->sendMemReq(requestPacket, false, BusRdUpd);
             }
             else{
@@ -392,6 +484,7 @@ void DragonCache::handleCoherentBusGrant() {
     }
 
     busStatsUpdate(busOp, requestPacket->getSize());
+    sectorStats.transactions[getSector(addr)]++;
 }
 
 // // Track if we're already handling a memory response to prevent reentrant calls
@@ -430,11 +523,12 @@ void DragonCache::handleCoherentMemResp(PacketPtr respPacket) {
     if (cacheHit) {
         assert(lineID != NOT_EXIST);
         cacheLine &currCacheline = DragonCacheMgr[setID].cacheSet[lineID];
-        assert(currCacheline.cohState == DragonState::SHARED_CLEAN || 
-            currCacheline.cohState == DragonState::SHARED_MOD);
+        Sector &currSector = currCacheline.sectors[getSector(addr)];
+        assert(currSector.cohState == DragonState::SHARED_CLEAN || 
+            currSector.cohState == DragonState::SHARED_MOD);
         assert(!memoryFetch);
 
-        if(currCacheline.cohState == DragonState::SHARED_CLEAN){
+        if(currSector.cohState == DragonState::SHARED_CLEAN){
             // print trans info
             if(bus->sharedWire)
                 DPRINTF(CCache, "STATE_PrWr: dragon[%d] storing DATA at addr %#x, Shared_Clean to Shared_Mod\n", cacheId, addr);
@@ -450,8 +544,8 @@ void DragonCache::handleCoherentMemResp(PacketPtr respPacket) {
         
         // BusOperationType opType = bus->getOperationType(pkt);
         
-        currCacheline.cohState = bus->sharedWire ? DragonState::SHARED_MOD : DragonState::MODIFIED;
-        currCacheline.dirty = true;
+        currSector.cohState = bus->sharedWire ? DragonState::SHARED_MOD : DragonState::MODIFIED;
+        currSector.dirty = true;
         currCacheline.clkFlag = 1;
         // can only modify parts that requested
         requestPacket->writeDataToBlock(&currCacheline.cacheBlock[0], blockSize);
@@ -471,28 +565,28 @@ void DragonCache::handleCoherentMemResp(PacketPtr respPacket) {
 
     }
 
-    // if no hit, must be invalid
-    assert(lineID == NOT_EXIST);
-
-    evict(addr);
-
-    lineID = allocate(addr);
+    // if no hit, the sector is invalid, the block may still be present
+    if(lineID == NOT_EXIST){
+        evict(addr);
+        lineID = allocate(addr);
+    }
     cacheLine &currCacheline = DragonCacheMgr[setID].cacheSet[lineID];
-    assert(currCacheline.cohState == DragonState::INVALID);
+    Sector &currSector = currCacheline.sectors[getSector(addr)];
+    assert(currSector.cohState == DragonState::INVALID);
     assert(currCacheline.valid);
 
     if(isRead){
         // read miss
         assert(memoryFetch);
         // decide on exclusive or shared based on snoop result
-        currCacheline.cohState = (bus->sharedWire)? DragonState::SHARED_CLEAN : DragonState::EXCLUSIVE;
+        currSector.cohState = (bus->sharedWire)? DragonState::SHARED_CLEAN : DragonState::EXCLUSIVE;
         // reset shared wire
         bus->sharedWire = false;
         currCacheline.clkFlag = 1;
         respPacket->writeDataToBlock(&currCacheline.cacheBlock[0], blockSize);
         requestPacket->setDataFromBlock(&currCacheline.cacheBlock[0], blockSize);
 
-        if(currCacheline.cohState == DragonState::EXCLUSIVE){
+        if(currSector.cohState == DragonState::EXCLUSIVE){
             DPRINTF(CCache, "STATE_PrRd Miss: Dragon[%d] got DATA from read and Invalid to Exclusive\n\n", cacheId);
         }
         else{
@@ -504,8 +598,8 @@ void DragonCache::handleCoherentMemResp(PacketPtr respPacket) {
     }
     else{
         // DPRINTF(CCache, "dragon[%d] storing %d in cache\n\n", cacheId, dataToWrite[0]);
-        currCacheline.cohState = (bus->sharedWire)? DragonState::SHARED_MOD : DragonState::MODIFIED;
-        currCacheline.dirty = true;
+        currSector.cohState = (bus->sharedWire)? DragonState::SHARED_MOD : DragonState::MODIFIED;
+        currSector.dirty = true;
         currCacheline.clkFlag = 1;
         bus->sharedWire = false;
 
@@ -514,7 +608,7 @@ void DragonCache::handleCoherentMemResp(PacketPtr respPacket) {
         }
         requestPacket->writeDataToBlock(&currCacheline.cacheBlock[0], blockSize);
 
-        if(currCacheline.cohState == DragonState::MODIFIED){
+        if(currSector.cohState == DragonState::MODIFIED){
             DPRINTF(CCache, "STATE_PrWr Miss: Dragon[%d] write DATA and Invalid to Modified\n\n", cacheId);
         }
         else{
@@ -558,6 +652,7 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
     BusOperationType opType = bus->getOperationType(pkt);
     DragonState currState;
     cacheLine *cachelinePtr;
+    Sector *sectorPtr;
     
     DPRINTF(CCache, "dragon[%d] received snoop for addr %#x opType=%d\n", 
             cacheId, addr, opType);
@@ -567,8 +662,9 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
         currState = DragonState::INVALID;
     }
     else{
-        currState = DragonCacheMgr[setID].cacheSet[lineID].cohState;
         cachelinePtr = &DragonCacheMgr[setID].cacheSet[lineID];
+        sectorPtr = &cachelinePtr->sectors[getSector(addr)];
+        currState = sectorPtr->cohState;
         // one or more caches have shared copies
         bus->sharedWire = true;
     }
@@ -578,18 +674,18 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
         case DragonState::MODIFIED:
 
             // flush
-            assert(cachelinePtr->dirty);
+            assert(sectorPtr->dirty);
             assert(bus->hasBusRd(opType));
             // writeback data
             writeback(addr, &cachelinePtr->cacheBlock[0]);
             // bus stats record flush data
-            bus->stats.rdBytes += blockSize;
+            bus->stats.rdBytes += sectorSize;
 
-            cachelinePtr->dirty = false;
+            sectorPtr->dirty = false;
             
             DPRINTF(CCache, "dragon[%d] snoop hit! Flush modified data\n\n", cacheId);
 
-            cachelinePtr->cohState = DragonState::SHARED_MOD;
+            sectorPtr->cohState = DragonState::SHARED_MOD;
             DPRINTF(CCache, "STATE_BusRd: dragon[%d] BusRd hit! set: %d, way: %d, tag: %d, Modified to Shared_Mod\n\n", cacheId, setID, lineID, tag);
 
             if(!bus->hasBusUpd(opType)){
@@ -603,20 +699,20 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
             // may or may not be synced with memory
             // can be busrd, bsupd or together
 
-            if(bus->hasBusRd(opType) && cachelinePtr->dirty){
+            if(bus->hasBusRd(opType) && sectorPtr->dirty){
                 writeback(addr, &cachelinePtr->cacheBlock[0]);
                 // bus stats record flush data
-                bus->stats.rdBytes += blockSize;
+                bus->stats.rdBytes += sectorSize;
 
-                cachelinePtr->dirty = false;
+                sectorPtr->dirty = false;
                 DPRINTF(CCache, "dragon[%d] snoop hit! Flush shared modified data\n\n", cacheId);
             }
 
             if(bus->hasBusUpd(opType)){
                 assert(pkt->isWrite());
                 pkt->writeDataToBlock(&cachelinePtr->cacheBlock[0], blockSize);
-                cachelinePtr->cohState = DragonState::SHARED_CLEAN;
-                cachelinePtr->dirty = false;
+                sectorPtr->cohState = DragonState::SHARED_CLEAN;
+                sectorPtr->dirty = false;
                 DPRINTF(CCache, "STATE_BusUpd: dragon[%d] BusUpd hit! set: %d, way: %d, tag: %d, Shared_Mod to Shared_Clean\n\n", cacheId, setID, lineID, tag);
             }
 
@@ -624,10 +720,10 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
 
         case DragonState::EXCLUSIVE:
 
-            assert(!cachelinePtr->dirty);
+            assert(!sectorPtr->dirty);
             assert(bus->hasBusRd(opType));
 
-            cachelinePtr->cohState = DragonState::SHARED_CLEAN;
+            sectorPtr->cohState = DragonState::SHARED_CLEAN;
             DPRINTF(CCache, "STATE_BusRd: dragon[%d] BusRd hit! set: %d, way: %d, tag: %d, Exclusive to Shared_Clean\n\n", cacheId, setID, lineID, tag);
 
             if(!bus->hasBusUpd(opType)){
@@ -661,4 +757,26 @@ void DragonCache::handleCoherentSnoopedReq(PacketPtr pkt) {
 
 }
 
+void DragonCache::handleBackInvalidate(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return;
+    }
+
+    uint64_t setID = getSet(addr);
+    cacheLine &cline = DragonCacheMgr[setID].cacheSet[lineID];
+    Sector &sec = cline.sectors[getSector(addr)];
+    DPRINTF(CCache, "dragon[%d] back invalidate set: %d, way: %d for %#x\n\n", cacheId, setID, lineID, addr);
+    noteTransition(TraceEvict, getSectorAddr(addr), (int)sec.cohState,
+                   (int)DragonState::INVALID, sec.dirty ? sectorSize : 0);
+
+    // the level below gets the latest data before dropping the sector
+    if(sec.dirty){
+        writeback(addr, &cline.cacheBlock[0]);
+        sec.dirty = false;
+    }
+
+    sec.cohState = DragonState::INVALID;
+}
+
 } // namespace gem5
@@ -32,11 +32,16 @@ private:
 
 public:
 
+    typedef struct Sector{
+        DragonState cohState;
+        bool dirty;
+    } sector;
+
     typedef struct CacheLine{
         std::vector<uint8_t> cacheBlock;
         uint64_t tag;
-        DragonState cohState;
-        bool dirty;
+        // coherence is kept per sector, the sectors share the tag
+        std::vector<Sector> sectors;
         bool clkFlag;
         // for replacement, more like existence, should be the same
         // as found in tagMap
@@ -69,6 +74,26 @@ public:
     int cacheSize = 32 * 1024;
     int numLines;
 
+    // a block has 2^sectorBit sectors, the unit of coherence and of bus
+    // transactions
+    int sectorBit = 0;
+    int numSectors = 1;
+    int sectorSize = 32;
+
+    struct SectorStats : public statistics::Group {
+        SectorStats(DragonCache *cache);
+        void regStats() override;
+
+        DragonCache *cache;
+
+        // by sector index within the block
+        statistics::Vector hits;
+        statistics::Vector misses;
+        statistics::Vector transactions;
+        // misses to a block whose tag was present
+        statistics::Scalar tagHitMisses;
+    } sectorStats;
+
     std::vector<cacheSetMgr> DragonCacheMgr;
 
     uint64_t getTag(long addr);
@@ -79,7 +104,12 @@ public:
     void writeback(long addr, uint8_t* data);
     void printDataHex(uint8_t* data, int length);
     uint64_t getBlkAddr(long addr);
+    int getSector(long addr);
+    uint64_t getSectorAddr(long addr);
     uint64_t constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset);
+    int getCohState(Addr addr) override;
+    int numCohStates() const override;
+    std::string cohStateName(int state) const override;
 
     DragonCache(const DragonCacheParams &params);
 
@@ -88,6 +118,7 @@ public:
     void handleCoherentBusGrant() override;
     void handleCoherentMemResp(PacketPtr respPacket) override;
     void handleCoherentSnoopedReq(PacketPtr pkt) override;
+    void handleBackInvalidate(Addr addr) override;
     
     // Helper method to get state name for logging
     const char* getStateName(DragonState state) {
@@ -48,11 +48,17 @@ HybridCache::HybridCache(const HybridCacheParams& params)
 
 
 void HybridCache::printDataHex(uint8_t* data, int length){
-    DPRINTF(CCache, "DATA: ");
+    // format only when CCache debugging is on, never straight to stdout
+    if (!debug::CCache) {
+        return;
+    }
+    std::string hex;
+    char byteStr[3];
     for(int i = 0; i < length; i++){
-        printf("%02x", data[i]);
+        snprintf(byteStr, sizeof(byteStr), "%02x", data[i]);
+        hex += byteStr;
     }
-    printf("\n");
+    DPRINTF(CCache, "DATA: %s\n", hex);
 }
 
 uint64_t HybridCache::getTag(long addr){
@@ -92,6 +98,24 @@ bool HybridCache::isHit(long addr, int &lineID) {
     return (exist && (HybridCacheMgr[setID].cacheSet[lineID].cohState != HybridState::INVALID));
 }
 
+int HybridCache::getCohState(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return (int)HybridState::INVALID;
+    }
+    return (int)HybridCacheMgr[getSet(addr)].cacheSet[lineID].cohState;
+}
+
+int HybridCache::numCohStates() const {
+    return 5;
+}
+
+std::string HybridCache::cohStateName(int state) const {
+    // in HybridState order
+    static const char *names[] = {"I", "E", "M", "Sc", "Sm"};
+    return names[state];
+}
+
 int HybridCache::allocate(long addr) {
     // assume clk_ptr now points to a empty line
     uint64_t setID = getSet(addr);
@@ -140,6 +164,9 @@ void HybridCache::evict(long addr) {
             // evict block
             cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
             DPRINTF(CCache, "hybrid[%d] replaces set: %d, way: %d, block tag: %#x, for %#x\n\n", cacheId, setID, setMgr.clkPtr, cline.tag, addr);
+            noteTransition(TraceEvict, constructAddr(cline.tag, setID, 0),
+                           (int)cline.cohState, (int)HybridState::INVALID,
+                           cline.dirty ? blockSize : 0);
             // write back if dirty
             if(cline.dirty){
                 assert(cline.cohState == HybridState::MODIFIED || cline.cohState == HybridState::SHARED_MOD);
@@ -194,8 +221,8 @@ void HybridCache::handleCoherentCpuReq(PacketPtr pkt) {
 
         assert(pkt->needsResponse());
 
-        localStats.hitCount++;
-        DPRINTF(CCache, "hybrid[%d] cache hit #%d\n", cacheId, localStats.hitCount);
+        noteHit();
+        DPRINTF(CCache, "hybrid[%d] cache hit #%d\n", cacheId, stats.hitCount.value());
 
         if (isRead) {
             // no state change or snoop needed, reply now
@@ -284,12 +311,12 @@ void HybridCache::handleCoherentCpuReq(PacketPtr pkt) {
         // Cache miss handling 
 
         // stats collection start
-        localStats.missCount++;
+        noteMiss();
 
        // std::cerr << "hybrid[" << cacheId << "] " << (isRead ? "read" : "write") 
         //         << " miss for addr " << std::hex << addr << std::dec << "\n";
         DPRINTF(CCache, "hybrid[%d] %s miss #%d for addr %#x\n", 
-                cacheId, isRead ? "read" : "write", localStats.missCount, addr);
+                cacheId, isRead ? "read" : "write", stats.missCount.value(), addr);
         
         // For both read and write misses, we need to get bus access
 
@@ -724,4 +751,25 @@ void HybridCache::handleCoherentSnoopedReq(PacketPtr pkt) {
 
 }
 
+void HybridCache::handleBackInvalidate(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return;
+    }
+
+    uint64_t setID = getSet(addr);
+    cacheLine &cline = HybridCacheMgr[setID].cacheSet[lineID];
+    DPRINTF(CCache, "hybrid[%d] back invalidate set: %d, way: %d for %#x\n\n", cacheId, setID, lineID, addr);
+    noteTransition(TraceEvict, getBlkAddr(addr), (int)cline.cohState,
+                   (int)HybridState::INVALID, cline.dirty ? blockSize : 0);
+
+    // the level below gets the latest data before dropping the block
+    if(cline.dirty){
+        writeback(addr, &cline.cacheBlock[0]);
+        cline.dirty = false;
+    }
+
+    cline.cohState = HybridState::INVALID;
+}
+
 } // namespace gem5
@@ -83,6 +83,9 @@ public:
     void printDataHex(uint8_t* data, int length);
     uint64_t getBlkAddr(long addr);
     uint64_t constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset);
+    int getCohState(Addr addr) override;
+    int numCohStates() const override;
+    std::string cohStateName(int state) const override;
 
     HybridCache(const HybridCacheParams &params);
 
@@ -91,6 +94,7 @@ public:
     void handleCoherentBusGrant() override;
     void handleCoherentMemResp(PacketPtr respPacket) override;
     void handleCoherentSnoopedReq(PacketPtr pkt) override;
+    void handleBackInvalidate(Addr addr) override;
     
     // Helper method to get state name for logging
     const char* getStateName(HybridState state) {
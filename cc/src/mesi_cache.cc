@@ -54,11 +54,17 @@ MesiCache::MesiCache(const MesiCacheParams& params)
 }
 
 void MesiCache::printDataHex(uint8_t* data, int length){
-    DPRINTF(CCache, "DATA: ");
+    // format only when CCache debugging is on, never straight to stdout
+    if (!debug::CCache) {
+        return;
+    }
+    std::string hex;
+    char byteStr[3];
     for(int i = 0; i < length; i++){
-        printf("%02x", data[i]);
+        snprintf(byteStr, sizeof(byteStr), "%02x", data[i]);
+        hex += byteStr;
     }
-    printf("\n");
+    DPRINTF(CCache, "DATA: %s\n", hex);
 }
 
 uint64_t MesiCache::getTag(long addr){
@@ -98,6 +104,24 @@ bool MesiCache::isHit(long addr, int &lineID) {
     return (exist && (MesiCacheMgr[setID].cacheSet[lineID].cohState != MesiState::Invalid));
 }
 
+int MesiCache::getCohState(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return (int)MesiState::Invalid;
+    }
+    return (int)MesiCacheMgr[getSet(addr)].cacheSet[lineID].cohState;
+}
+
+int MesiCache::numCohStates() const {
+    return 4;
+}
+
+std::string MesiCache::cohStateName(int state) const {
+    // in MesiState order
+    static const char *names[] = {"I", "M", "S", "E"};
+    return names[state];
+}
+
 int MesiCache::allocate(long addr) {
     // assume clk_ptr now points to a empty line
     uint64_t setID = getSet(addr);
@@ -145,6 +169,9 @@ void MesiCache::evict(long addr) {
             // evict block
             cacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
             DPRINTF(CCache, "Mesi[%d] replaces set: %d, way: %d, block tag: %#x, for %#x\n\n", cacheId, setID, setMgr.clkPtr, cline.tag, addr);
+            noteTransition(TraceEvict, constructAddr(cline.tag, setID, 0),
+                           (int)cline.cohState, (int)MesiState::Invalid,
+                           cline.dirty ? blockSize : 0);
             // write back if dirty
             if(cline.dirty){
                 assert(cline.cohState == MesiState::Modified);
@@ -197,8 +224,8 @@ void MesiCache::handleCoherentCpuReq(PacketPtr pkt) {
         
         assert(currCacheline.cohState != MesiState::Invalid);
         
-        localStats.hitCount++;
-        DPRINTF(CCache, "dragon[%d] cache hit #%d\n", cacheId, localStats.hitCount);
+        noteHit();
+        DPRINTF(CCache, "dragon[%d] cache hit #%d\n", cacheId, stats.hitCount.value());
 
         if (isRead) {
             // no state change or snoop needed, reply now
@@ -259,10 +286,10 @@ void MesiCache::handleCoherentCpuReq(PacketPtr pkt) {
         // miss
         
         // stats collection start
-        localStats.missCount++;
+        noteMiss();
 
         DPRINTF(CCache, "Mesi[%d] cache %s miss #%d for addr %#x\n", 
-                 cacheId, isRead ? "read" : "write", localStats.missCount, addr);
+                 cacheId, isRead ? "read" : "write", stats.missCount.value(), addr);
         // if invalidate, need to "read" from memory, may change other cache state
         requestPacket = pkt;
         if (pkt->isWrite()) {
@@ -595,6 +622,25 @@ void MesiCache::handleCoherentSnoopedReq(PacketPtr pkt) {
 
 }
 
+void MesiCache::handleBackInvalidate(Addr addr) {
+    int lineID;
+    if(!isHit(addr, lineID)){
+        return;
+    }
 
+    uint64_t setID = getSet(addr);
+    cacheLine &cline = MesiCacheMgr[setID].cacheSet[lineID];
+    DPRINTF(CCache, "Mesi[%d] back invalidate set: %d, way: %d for %#x\n\n", cacheId, setID, lineID, addr);
+    noteTransition(TraceEvict, getBlkAddr(addr), (int)cline.cohState,
+                   (int)MesiState::Invalid, cline.dirty ? blockSize : 0);
+
+    // the level below gets the latest data before dropping the block
+    if(cline.dirty){
+        writeback(addr, &cline.cacheBlock[0]);
+        cline.dirty = false;
+    }
 
-}
\ No newline at end of file
+    cline.cohState = MesiState::Invalid;
+}
+
+}
@@ -74,10 +74,14 @@ class MesiCache : public CoherentCacheBase {
     void printDataHex(uint8_t* data, int length);
     uint64_t getBlkAddr(long addr);
     uint64_t constructAddr(uint64_t tag, uint64_t set, uint64_t blkOffset);
+    int getCohState(Addr addr) override;
+    int numCohStates() const override;
+    std::string cohStateName(int state) const override;
     
     void handleCoherentCpuReq(PacketPtr pkt) override;
     void handleCoherentBusGrant() override;
     void handleCoherentMemResp(PacketPtr pkt) override;
     void handleCoherentSnoopedReq(PacketPtr pkt) override;
+    void handleBackInvalidate(Addr addr) override;
 };
 }
\ No newline at end of file
@@ -1,27 +1,168 @@
 #include "src_740/serializing_bus.hh"
 #include "src_740/coherent_cache_base.hh"
+#include "src_740/cluster_cache.hh"
+#include "src_740/shared_llc.hh"
+#include "base/output.hh"
 #include "base/trace.hh"
 #include "debug/SBus.hh"
-#include <iostream>
+#include "sim/sim_exit.hh"
+#include "sim/stats.hh"
 
 namespace gem5 {
 
 SerializingBus::SerializingBus(const SerializingBusParams& params)
     : SimObject(params),
       memPort(params.name + ".mem_side", this),
+      busRespEvent([this](){ processBusRespEvent(); }, name()),
+      grantLatency(params.grant_latency),
+      requestLatency(params.request_latency),
+      snoopRetryLatency(params.snoop_retry_latency),
+      busPeriod(params.bus_clock),
+      busWidth(params.bus_width),
+      arbitrationCycles(params.arbitration_cycles),
+      snoopCycles(params.snoop_cycles),
+      beatCycles(params.beat_cycles),
+      arbiter(BusArbiter::create(params.arbitration_policy,
+                                 params.arbitration_weights,
+                                 params.arbitration_read_bonus)),
       memReqEvent([this](){ processMemReqEvent(); }, name()), 
       grantEvent([this](){ processGrantEvent(); }, name()),
-      currentGranted(-1) {
-        stats.transCount = 0;
-        stats.rdxCount = 0;
-        stats.rdCount = 0;
-        stats.updCount = 0;
-        stats.rdBytes = 0;
-        stats.updBytes = 0;
-      }
+      currentGranted(-1),
+      grantWaitMax(params.grant_wait_max),
+      stats(this),
+      energy(this, params),
+      traceEnabled(params.coherence_trace),
+      traceBufferRecords(params.trace_buffer_records),
+      profileEnabled(params.sharing_profile) {
+    fatal_if(busWidth == 0, "%s: bus_width must be at least 1 byte",
+             name());
+}
+
+BusStats::BusStats(SerializingBus *bus)
+    : statistics::Group(bus),
+      bus(bus),
+      ADD_STAT(transCount, statistics::units::Count::get(),
+               "total bus transactions, BusRdUpd counts twice"),
+      ADD_STAT(rdxCount, statistics::units::Count::get(),
+               "BusRdX transactions"),
+      ADD_STAT(rdCount, statistics::units::Count::get(),
+               "BusRd transactions, including the read of BusRdUpd"),
+      ADD_STAT(updCount, statistics::units::Count::get(),
+               "BusUpd transactions, including the update of BusRdUpd"),
+      ADD_STAT(rdBytes, statistics::units::Byte::get(),
+               "bytes flushed by snooping caches"),
+      ADD_STAT(updBytes, statistics::units::Byte::get(),
+               "bytes sent by bus updates"),
+      ADD_STAT(snoopRetries, statistics::units::Count::get(),
+               "snoops repeated for a cluster's local transaction"),
+      ADD_STAT(clusterStalls, statistics::units::Count::get(),
+               "grants held back for the cluster cache to get the block"),
+      ADD_STAT(snoopsFiltered, statistics::units::Count::get(),
+               "snoops skipped by the shared LLC's sharer bits"),
+      ADD_STAT(opCount, statistics::units::Count::get(),
+               "transactions issued on the bus by operation"),
+      ADD_STAT(opBytes, statistics::units::Byte::get(),
+               "update and memory fill bytes by operation"),
+      ADD_STAT(busyTicks, statistics::units::Tick::get(),
+               "ticks of command, snoop and data phases on the bus"),
+      ADD_STAT(dataBeats, statistics::units::Count::get(),
+               "data beats on the bus"),
+      ADD_STAT(utilization, statistics::units::Ratio::get(),
+               "fraction of the time the bus was busy",
+               busyTicks / simTicks),
+      ADD_STAT(grants, statistics::units::Count::get(),
+               "bus grants by cache id"),
+      ADD_STAT(grantWait, statistics::units::Tick::get(),
+               "ticks from bus request to grant by cache id"),
+      ADD_STAT(maxGrantWait, statistics::units::Tick::get(),
+               "longest wait from bus request to grant by cache id") {}
+
+void BusStats::regStats() {
+    statistics::Group::regStats();
+
+    static const char *opNames[] = {"BusRdX", "BusRd", "BusUpd", "BusRdUpd"};
+    opCount.init(4);
+    opBytes.init(4);
+    for (int op = 0; op < 4; op++) {
+        opCount.subname(op, opNames[op]);
+        opBytes.subname(op, opNames[op]);
+    }
 
+    // the caches registered in init()
+    int numCaches = bus->maxCacheId() + 1;
+    Tick bucket = std::max<Tick>(bus->grantWaitMax / 20, 1);
+    grants.init(numCaches);
+    grantWait.init(numCaches, 0, bus->grantWaitMax, bucket);
+    maxGrantWait.init(numCaches);
+    for (int id = 0; id < numCaches; id++) {
+        grants.subname(id, std::to_string(id));
+        grantWait.subname(id, std::to_string(id));
+        maxGrantWait.subname(id, std::to_string(id));
+    }
+}
+
+// energy params are in pJ
+static const double picoJoule = 1e-12;
+
+BusEnergy::BusEnergy(statistics::Group *parent,
+                     const SerializingBusParams &params)
+    : statistics::Group(parent, "energy"),
+      opEnergy{params.energy_bus_rdx * picoJoule,
+               params.energy_bus_rd * picoJoule,
+               params.energy_bus_upd * picoJoule,
+               params.energy_bus_rdupd * picoJoule},
+      byteEnergy(params.energy_bus_byte * picoJoule),
+      snoopEnergy(params.energy_snoop * picoJoule),
+      dataReadEnergy(params.energy_data_read * picoJoule),
+      dataWriteEnergy(params.energy_data_write * picoJoule),
+      dramEnergy(params.energy_dram * picoJoule),
+      ADD_STAT(busOp, statistics::units::Joule::get(),
+               "energy of bus transactions"),
+      ADD_STAT(busTransfer, statistics::units::Joule::get(),
+               "energy of the bytes moved on the bus"),
+      ADD_STAT(snoop, statistics::units::Joule::get(),
+               "energy of snoop tag lookups"),
+      ADD_STAT(dataRead, statistics::units::Joule::get(),
+               "energy of cache data array reads"),
+      ADD_STAT(dataWrite, statistics::units::Joule::get(),
+               "energy of cache data array writes"),
+      ADD_STAT(dram, statistics::units::Joule::get(),
+               "energy of DRAM block reads and writes"),
+      ADD_STAT(total, statistics::units::Joule::get(),
+               "total energy of bus, caches and DRAM",
+               busOp + busTransfer + snoop + dataRead + dataWrite + dram),
+      ADD_STAT(edp, statistics::units::Unspecified::get(),
+               "energy-delay product (J*s)", total * simSeconds) {}
+
+void SerializingBus::init() {
+    if (traceEnabled) {
+        trace.open(simout.resolve(name() + ".cctrace"), traceBufferRecords);
+        // simobjects are not destroyed at exit, flush the tail here
+        registerExitCallback([this]() { trace.close(); });
+    }
+
+    if (profileEnabled) {
+        // the caches set the block size when they are constructed
+        profiler.init(cacheBlockSize);
+        registerExitCallback([this]() {
+            OutputStream *out = simout.create(name() + ".sharing.txt");
+            profiler.dump(*out->stream());
+            simout.close(out);
+        });
+    }
+}
+
+
+Tick SerializingBus::dataPhase(unsigned bytes) {
+    unsigned beats = (bytes + busWidth - 1) / busWidth;
+    Tick ticks = beats * beatCycles * busPeriod;
+    stats.dataBeats += beats;
+    stats.busyTicks += ticks;
+    return ticks;
+}
 
-void SerializingBus::generateAlignAccess(PacketPtr pkt){
+void SerializingBus::generateAlignAccess(PacketPtr pkt, int originator,
+                                         Tick dataReady){
 
     // need to align memory access on block size
     uint64_t addr = pkt->getAddr();
@@ -37,21 +178,15 @@ void SerializingBus::generateAlignAccess(PacketPtr pkt){
     // delete pkt;
 
     pkt = newreqPacket;
+    memRespOriginator[newreqPacket] = originator;
+    memDataReady[newreqPacket] = dataReady;
     memPort.sendPacket(newreqPacket);
 }
 
 void SerializingBus::processMemReqEvent() {
-    // If there's no valid originator but we have pending requests,
-    // delay processing until later when we might have a valid originator
-    if (currentGranted == -1 && !memReqQueue.empty()) {
-        if (!memReqEvent.scheduled()) {
-            std::cerr << "Bus: Delay Processing\n";
-            schedule(memReqEvent, curTick()+100);
-        }
-        return;
-    }
-    
-    while(!memReqQueue.empty()) {
+    // every request carries its originator, so it can be processed as soon
+    // as it has crossed the bus even if the bus was released meanwhile
+    while(!memReqQueue.empty() && std::get<3>(memReqQueue.front()) <= curTick()) {
         auto first = memReqQueue.begin();
         auto bundle = *first;
         memReqQueue.erase(first);
@@ -67,38 +202,122 @@ void SerializingBus::processMemReqEvent() {
         
         // Get the operation type
         BusOperationType opType = getOperationType(pkt);
+
+        if (trace.enabled()) {
+            trace.record(curTick(), originator, addr, opType, 0, 0,
+                         TraceFromBus, pkt->getSize());
+        }
+
+        bool cacheable = cacheMap[originator]->isCacheablePacket(pkt);
+
+        // payload: the update data plus a block fill from memory
+        stats.opCount[opType]++;
+        if (hasBusUpd(opType)) {
+            stats.opBytes[opType] += pkt->getSize();
+        }
+        if (sendToMemory && cacheable) {
+            stats.opBytes[opType] += cacheBlockSize;
+        }
+
+        energy.transaction(opType);
+        if (hasBusUpd(opType)) {
+            energy.transfer(pkt->getSize());
+        }
+        if (sendToMemory) {
+            energy.transfer(cacheable ? cacheBlockSize : pkt->getSize());
+            // a cluster's fills come from the cluster cache, the shared
+            // LLC charges its own hits and misses
+            if (cluster != nullptr && cacheable) {
+                energy.dataArrayRead();
+            }
+            else if (llc == nullptr || !cacheable) {
+                energy.dramAccess();
+            }
+        }
+
+        if (profileEnabled && cacheable) {
+            profiler.recordTransaction(addr);
+        }
     
         // Send snoops to all other caches (not the originating cache)
+        snooping = true;
+        flushedBytes = 0;
         for (auto& it : cacheMap) {
-            // Only send snoops if there's a valid originator and it's not this cache
-            if (originator != -1 && it.first != originator) {
-                it.second->handleSnoopedReq(pkt);
+            if (it.first == originator) {
+                continue;
+            }
+            // by inclusion a cache without its sharer bit does not have
+            // the block
+            if (llc != nullptr && cacheable &&
+                !llc->isSharer(addr, it.first)) {
+                stats.snoopsFiltered++;
+                continue;
+            }
+            it.second->handleSnoopedReq(pkt);
+            if (llc != nullptr && cacheable &&
+                it.second->getCohState(addr) == 0) {
+                llc->removeSharer(addr, it.first);
             }
         }
+        snooping = false;
+
+        // a cluster is busy with the block, the originator keeps the bus
+        // and the transaction is snooped again later
+        if (retryWire) {
+            retryWire = false;
+            stats.snoopRetries++;
+            DPRINTF(SBus, "retrying snoop of %#x from %d\n\n", addr,
+                    originator);
+            memReqQueue.push_front(std::make_tuple(pkt, sendToMemory,
+                originator, curTick() + snoopRetryLatency));
+            break;
+        }
+
+        if (llc != nullptr && cacheable) {
+            llc->addSharer(addr, originator);
+        }
+
+        // occupancy: the command and snoop phase, then the update, flush
+        // and outgoing write data; a fill adds its beats when it arrives
+        stats.busyTicks += snoopCycles * busPeriod;
+        unsigned payload = flushedBytes;
+        if (hasBusUpd(opType) || (sendToMemory && !cacheable && !isRead)) {
+            payload += pkt->getSize();
+        }
+        Tick dataReady = curTick() + dataPhase(payload);
+
+        // the L1s of a cluster may only take a block exclusive when the
+        // cluster cache holds it exclusive
+        if (cluster != nullptr && cacheable &&
+            !cluster->hasPermission(addr, true)) {
+            sharedWire = true;
+        }
 
         // Send to memory system or process locally based on the sendToMemory flag
         if (sendToMemory) {
-            if(cacheMap[currentGranted]->isCacheablePacket(pkt)){
-                generateAlignAccess(pkt);
+            if(cacheable){
+                generateAlignAccess(pkt, originator, dataReady);
             }
             else{
+                memRespOriginator[pkt] = originator;
+                memDataReady[pkt] = dataReady;
                 memPort.sendPacket(pkt);
             }
         }
         else {
             assert(!isRead);
-            
-            // Make response only if needed and if there's a valid originator
-            if (originator != -1) {
-                if (pkt->needsResponse()) {
-                    pkt->makeResponse();
-                }
-                cacheMap[originator]->handleResponse(pkt);
-            } else {
-                std::cerr << "Bus: Warning - no valid originator to handle response\n";
+
+            if (pkt->needsResponse()) {
+                pkt->makeResponse();
             }
+            queueBusResp(pkt, originator, dataReady);
         }
     }
+
+    // wake up again when the next queued request reaches the bus
+    if (!memReqQueue.empty() && !memReqEvent.scheduled()) {
+        schedule(memReqEvent, std::get<3>(memReqQueue.front()));
+    }
 }
 
 Port& SerializingBus::getPort(const std::string& port_name, PortID idx) {
@@ -123,13 +342,53 @@ void SerializingBus::sendRangeChange() {
 }
 
 bool SerializingBus::handleResponse(PacketPtr pkt) {
-    // Make sure we have a valid currentGranted before accessing the cache map
-    if (currentGranted != -1) {
-        cacheMap[currentGranted]->handleResponse(pkt);
-        return true;
-    } else {
-        std::cerr << "Bus: Warning - received response with no valid granted cache\n";
-        return false;
+    // route the response to the cache that sent the request
+    auto it = memRespOriginator.find(pkt);
+    panic_if(it == memRespOriginator.end(),
+             "bus received a response it never requested: %s", pkt->print());
+    int originator = it->second;
+    memRespOriginator.erase(it);
+
+    Tick dataReady = curTick();
+    auto ready = memDataReady.find(pkt);
+    if (ready != memDataReady.end()) {
+        dataReady = std::max(dataReady, ready->second);
+        memDataReady.erase(ready);
+    }
+    // the fill follows the transaction's other data on the bus
+    if (pkt->isRead()) {
+        dataReady += dataPhase(pkt->getSize());
+    }
+    queueBusResp(pkt, originator, dataReady);
+    return true;
+}
+
+void SerializingBus::queueBusResp(PacketPtr pkt, int originator, Tick when) {
+    auto pos = busRespQueue.end();
+    while (pos != busRespQueue.begin() && std::get<2>(*std::prev(pos)) > when) {
+        pos--;
+    }
+    busRespQueue.insert(pos, std::make_tuple(pkt, originator, when));
+
+    Tick next = std::get<2>(busRespQueue.front());
+    if (!busRespEvent.scheduled()) {
+        schedule(busRespEvent, next);
+    }
+    else if (busRespEvent.when() > next) {
+        reschedule(busRespEvent, next);
+    }
+}
+
+void SerializingBus::processBusRespEvent() {
+    while (!busRespQueue.empty() &&
+           std::get<2>(busRespQueue.front()) <= curTick()) {
+        auto bundle = busRespQueue.front();
+        busRespQueue.pop_front();
+        cacheMap[std::get<1>(bundle)]->handleResponse(std::get<0>(bundle));
+    }
+
+    if (!busRespQueue.empty() && !busRespEvent.scheduled()) {
+        schedule(busRespEvent, std::get<2>(busRespQueue.front()));
     }
 }
 
@@ -161,12 +420,105 @@ bool SerializingBus::MemSidePort::recvTimingResp(PacketPtr pkt) {
     return owner->handleResponse(pkt);
 }
 
+bool SerializingBus::clusterCanGrant(int cacheId) {
+    CoherentCacheBase *cache = cacheMap[cacheId];
+    PacketPtr pkt = cache->requestPacket;
+    if (pkt == nullptr || !cache->isCacheablePacket(pkt)) {
+        return true;
+    }
+
+    if (!cluster->hasPermission(pkt->getAddr(), pkt->isWrite())) {
+        DPRINTF(SBus, "grant to %d waits for the cluster to get %#x\n\n",
+                cacheId, pkt->getAddr());
+        clusterWait = true;
+        stats.clusterStalls++;
+        cluster->acquire(pkt->getAddr(), pkt->isWrite());
+        return false;
+    }
+
+    // global snoops to the block retry until this transaction is done
+    cluster->lock(pkt->getAddr());
+    return true;
+}
+
+void SerializingBus::clusterAcquired() {
+    assert(clusterWait);
+    clusterWait = false;
+    if (currentGranted == -1 && !grantEvent.scheduled()) {
+        schedule(grantEvent, curTick());
+    }
+}
+
+void SerializingBus::clusterDowngrade(Addr addr) {
+    // keep the wires of a local transaction that may be in flight
+    BusOperationType savedOp = currBusOp;
+    bool savedShared = sharedWire;
+    bool savedRemote = remoteAccessWire;
+
+    RequestPtr req = std::make_shared<Request>(addr, cacheBlockSize, 0, 0);
+    PacketPtr pkt = new Packet(req, MemCmd::ReadReq, cacheBlockSize);
+    pkt->allocate();
+    currBusOp = BusRd;
+    for (auto& it : cacheMap) {
+        it.second->handleSnoopedReq(pkt);
+    }
+    delete pkt;
+
+    currBusOp = savedOp;
+    sharedWire = savedShared;
+    remoteAccessWire = savedRemote;
+}
+
+void SerializingBus::clusterInvalidate(Addr addr) {
+    for (auto& it : cacheMap) {
+        it.second->handleBackInvalidate(addr);
+    }
+}
+
+bool SerializingBus::canBackInvalidate(int cacheId, Addr addr) {
+    auto it = cacheMap.find(cacheId);
+    return it == cacheMap.end() || it->second->canBackInvalidate(addr);
+}
+
+void SerializingBus::backInvalidate(int cacheId, Addr addr) {
+    auto it = cacheMap.find(cacheId);
+    if (it != cacheMap.end()) {
+        it->second->handleBackInvalidate(addr);
+    }
+}
+
 void SerializingBus::processGrantEvent() {
     assert(currentGranted == -1);
 
+    if (clusterWait) {
+        // clusterAcquired() grants again
+        return;
+    }
+
     if (busRequestQueue.size() != 0) {
         auto requestIt = busRequestQueue.begin();
-        int requestingCache = *requestIt;
+        if (clusterWaitCache != -1) {
+            while (requestIt->cacheId != clusterWaitCache) {
+                requestIt++;
+            }
+        }
+        else {
+            requestIt = arbiter->pick(busRequestQueue);
+        }
+        int requestingCache = requestIt->cacheId;
+        if (cluster != nullptr && !clusterCanGrant(requestingCache)) {
+            clusterWaitCache = requestingCache;
+            return;
+        }
+        clusterWaitCache = -1;
+
+        arbiter->granted(*requestIt);
+        Tick wait = curTick() - requestIt->arrival;
+        stats.grants[requestingCache]++;
+        stats.grantWait[requestingCache].sample(wait);
+        if (wait > stats.maxGrantWait[requestingCache].value()) {
+            stats.maxGrantWait[requestingCache] = wait;
+        }
         busRequestQueue.erase(requestIt);
         currentGranted = requestingCache;
         DPRINTF(SBus, "granting %d\n\n", currentGranted);
@@ -184,11 +536,14 @@ void SerializingBus::sendMemReq(PacketPtr pkt, bool sendToMemory, BusOperationTy
     currBusOp = opType;
     
     // Store the request in the queue with the current granted cache as originator
-    memReqQueue.push_back(std::make_tuple(pkt, sendToMemory, currentGranted));
+    panic_if(currentGranted == -1, "bus request sent without a grant");
+    Tick ready = curTick() + requestLatency + snoopCycles * busPeriod;
+    memReqQueue.push_back(std::make_tuple(pkt, sendToMemory, currentGranted,
+                                          ready));
     
     // Schedule the event to process the request
     if (!memReqEvent.scheduled()) {
-        schedule(memReqEvent, curTick()+1);
+        schedule(memReqEvent, ready);
     }
 }
 
@@ -196,11 +551,13 @@ void SerializingBus::request(int cacheId) {
     DPRINTF(SBus, "access request from %d\n\n", cacheId);
     
     // Add the request to the queue
-    busRequestQueue.push_back(cacheId);
+    PacketPtr pkt = cacheMap[cacheId]->requestPacket;
+    bool demandRead = pkt != nullptr && pkt->isRead() && !pkt->isWrite();
+    busRequestQueue.push_back(BusRequest{cacheId, curTick(), demandRead});
     
     // If there is no request currently being handled, start the grant process
     if (currentGranted == -1 && !grantEvent.scheduled()) {
-        schedule(grantEvent, curTick()+1);
+        schedule(grantEvent, curTick() + arbitrationDelay());
     }
 }
 
@@ -209,18 +566,20 @@ void SerializingBus::release(int cacheId) {
     
     // Check if this cache actually has the bus before releasing
     if (cacheId != currentGranted) {
-        std::cerr << "Warning: Cache " << cacheId 
-                 << " tried to release bus but currentGranted is " 
-                 << currentGranted << "\n";
+        warn("cache %d tried to release bus but currentGranted is %d",
+             cacheId, currentGranted);
         return;  // Just return without doing anything
     }
     
     // Normal case - release the bus
     currentGranted = -1;
+    if (cluster != nullptr) {
+        cluster->unlock();
+    }
     
     // Schedule the event to potentially grant the bus to another cache
     if (!grantEvent.scheduled()) {
-        schedule(grantEvent, curTick()+1);
+        schedule(grantEvent, curTick() + arbitrationDelay());
     }
 }
 
@@ -247,6 +606,33 @@ void SerializingBus::sendWriteback(int cacheId, long addr, unsigned char data) {
 
 void SerializingBus::sendBlkWriteback(int cacheId, long addr, uint8_t *data, int blockSize) {
     DPRINTF(SBus, "sending writeback from %d @ %#x\n\n", cacheId, addr);
+    if (trace.enabled()) {
+        trace.record(curTick(), cacheId, addr, TraceFlush, 0, 0,
+                     TraceFromBus, blockSize);
+    }
+    // the block is read out of the cache and written to DRAM, or to the
+    // cluster cache, over the bus
+    energy.dataArrayRead();
+    energy.transfer(blockSize);
+    // a flush is part of the snooped transaction's data phase, other
+    // writebacks use the bus on their own
+    if (snooping) {
+        flushedBytes += blockSize;
+    }
+    else {
+        dataPhase(blockSize);
+    }
+    if (cluster != nullptr) {
+        energy.dataArrayWrite();
+    }
+    else {
+        // the shared LLC writes through to DRAM
+        if (llc != nullptr) {
+            energy.dataArrayWrite();
+        }
+        energy.dramAccess();
+    }
+
     RequestPtr req = std::make_shared<Request>(addr, blockSize, 0, 0);
     PacketPtr new_pkt = new Packet(req, MemCmd::WriteReq, blockSize);
     unsigned char* dataBlock = new uint8_t[blockSize];
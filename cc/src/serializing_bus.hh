@@ -1,19 +1,29 @@
 #pragma once
 
+#include "base/statistics.hh"
 #include "mem/port.hh"
 #include "params/SerializingBus.hh"
 #include "sim/sim_object.hh"
 
+#include "src_740/bus_arbiter.hh"
+#include "src_740/coherence_trace.hh"
+#include "src_740/sharing_profiler.hh"
+
 #include <list>
 #include <map>
+#include <memory>
 #include <unordered_set>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace gem5 {
 
 // Forward declaration
 class CoherentCacheBase;
+class ClusterCache;
+class SharedLLC;
+class SerializingBus;
 
 // Define bus operation types
 enum BusOperationType {
@@ -23,14 +33,72 @@ enum BusOperationType {
     BusRdUpd = 3
 };
 
-typedef struct BUSStats{
-  int transCount;
-  int rdxCount;
-  int rdCount;
-  int updCount;
-  int rdBytes;
-  int updBytes;
-} BusStats;
+// bus totals, the counters the CCache debug output prints
+struct BusStats : public statistics::Group {
+  BusStats(SerializingBus *bus);
+  void regStats() override;
+
+  SerializingBus *bus;
+
+  statistics::Scalar transCount;
+  statistics::Scalar rdxCount;
+  statistics::Scalar rdCount;
+  statistics::Scalar updCount;
+  statistics::Scalar rdBytes;
+  statistics::Scalar updBytes;
+
+  // snoops repeated because a cluster had a local transaction on the block,
+  // and grants held back until the cluster cache acquired the block
+  statistics::Scalar snoopRetries;
+  statistics::Scalar clusterStalls;
+
+  // snoops skipped because the shared LLC's sharer bits rule the cache out
+  statistics::Scalar snoopsFiltered;
+
+  // transactions on the bus and their payload, by BusOperationType
+  statistics::Vector opCount;
+  statistics::Vector opBytes;
+
+  // ticks the bus spent in command, snoop and data phases
+  statistics::Scalar busyTicks;
+  statistics::Scalar dataBeats;
+  statistics::Formula utilization;
+
+  // arbitration, by cache id: ticks from request to grant
+  statistics::Vector grants;
+  statistics::VectorDistribution grantWait;
+  statistics::Vector maxGrantWait;
+};
+
+// energy of the bus, the caches' tag and data arrays and DRAM,
+// accumulated in joules as events happen
+struct BusEnergy : public statistics::Group {
+  BusEnergy(statistics::Group *parent, const SerializingBusParams &params);
+
+  // per event energy in joules
+  double opEnergy[4];
+  double byteEnergy;
+  double snoopEnergy;
+  double dataReadEnergy;
+  double dataWriteEnergy;
+  double dramEnergy;
+
+  statistics::Scalar busOp;
+  statistics::Scalar busTransfer;
+  statistics::Scalar snoop;
+  statistics::Scalar dataRead;
+  statistics::Scalar dataWrite;
+  statistics::Scalar dram;
+  statistics::Formula total;
+  statistics::Formula edp;
+
+  void transaction(BusOperationType op) { busOp += opEnergy[op]; }
+  void transfer(unsigned bytes) { busTransfer += bytes * byteEnergy; }
+  void snoopLookup() { snoop += snoopEnergy; }
+  void dataArrayRead() { dataRead += dataReadEnergy; }
+  void dataArrayWrite() { dataWrite += dataWriteEnergy; }
+  void dramAccess() { dram += dramEnergy; }
+};
 
 
 class SerializingBus : public SimObject {
@@ -58,21 +126,68 @@ class SerializingBus : public SimObject {
     // Map from cache ID to cache object
     std::map<int, CoherentCacheBase*> cacheMap;
 
-    // List of pending memory requests (packet, sendToMemory, originator)
-    std::list<std::tuple<PacketPtr, bool, int>> memReqQueue;
+    // List of pending memory requests
+    // (packet, sendToMemory, originator, tick it reaches the bus)
+    std::list<std::tuple<PacketPtr, bool, int, Tick>> memReqQueue;
+
+    // cache waiting for each packet sent to memory
+    std::unordered_map<PacketPtr, int> memRespOriginator;
+    // end of the update and flush beats of each packet sent to memory,
+    // its fill beats follow them
+    std::unordered_map<PacketPtr, Tick> memDataReady;
+
+    // responses in their data phase (packet, originator, tick it is done),
+    // in tick order
+    std::list<std::tuple<PacketPtr, int, Tick>> busRespQueue;
+    EventFunctionWrapper busRespEvent;
+    void queueBusResp(PacketPtr pkt, int originator, Tick when);
+    void processBusRespEvent();
+
+    // modeled latencies of arbitration and of a request crossing the bus
+    Tick grantLatency;
+    Tick requestLatency;
+    Tick snoopRetryLatency;
+
+    // width and clock based occupancy, see CoherentCache.py
+    Tick busPeriod;
+    unsigned busWidth;
+    unsigned arbitrationCycles;
+    unsigned snoopCycles;
+    unsigned beatCycles;
+    // bytes flushed by the caches snooping the current transaction
+    bool snooping = false;
+    unsigned flushedBytes = 0;
+
+    Tick arbitrationDelay() const {
+        return grantLatency + arbitrationCycles * busPeriod;
+    }
+    // count the data beats moving bytes and return their bus time
+    Tick dataPhase(unsigned bytes);
+
+    // cluster cache below this bus, if it is a cluster's local bus
+    ClusterCache *cluster = nullptr;
+    // a grant waits for the cluster cache to acquire the block
+    bool clusterWait = false;
+    bool clusterCanGrant(int cacheId);
+
+    // shared LLC below this bus, it filters the snoops
+    SharedLLC *llc = nullptr;
 
     // // Track the operation type for each packet
     // std::map<PacketPtr, BusOperationType> packetOpTypes;
 
-    // List of caches waiting for bus
-    std::list<int> busRequestQueue;
+    // caches waiting for the bus in arrival order, the arbiter picks one
+    std::list<BusRequest> busRequestQueue;
+    std::unique_ptr<BusArbiter> arbiter;
+    // cache whose grant waits for the cluster cache, it is granted next
+    int clusterWaitCache = -1;
 
     // Events for sending memory requests and granting the bus
     EventFunctionWrapper memReqEvent;
     EventFunctionWrapper grantEvent;
     
     // Event handling functions
-    void generateAlignAccess(PacketPtr pkt);
+    void generateAlignAccess(PacketPtr pkt, int originator, Tick dataReady);
     void processMemReqEvent();
     void processGrantEvent();
 
@@ -85,10 +200,20 @@ class SerializingBus : public SimObject {
 
     int cacheBlockSize = 32;
 
+    // histogram range of the grant waits
+    Tick grantWaitMax;
+    // largest registered cache id, to size the per cache stats
+    int maxCacheId() const {
+        return cacheMap.empty() ? 0 : cacheMap.rbegin()->first;
+    }
+
     bool sharedWire = false;
 
     bool remoteAccessWire = false;
 
+    // set by a snooping cluster cache to have the transaction snooped again
+    bool retryWire = false;
+
     BusOperationType currBusOp = BusRd;
 
     std::vector<int> invalidationThs;
@@ -96,9 +221,21 @@ class SerializingBus : public SimObject {
     // statistics
 
     BusStats stats;
+    BusEnergy energy;
+
+    // binary event trace, caches open their own when this is set
+    bool traceEnabled = false;
+    unsigned traceBufferRecords;
+    CoherenceTrace trace;
+
+    // per block sharing profile, fed by the caches when enabled
+    bool profileEnabled = false;
+    SharingProfiler profiler;
 
     SerializingBus(const SerializingBusParams& params);
 
+    void init() override;
+
     Port& getPort(const std::string& port_name, PortID idx = InvalidPortID) override;
 
     void sendMemReq(PacketPtr pkt, bool sendToMemory, BusOperationType opType);
@@ -123,6 +260,24 @@ class SerializingBus : public SimObject {
     // block write back
     void sendBlkWriteback(int cacheId, long addr, uint8_t *data, int blockSize);
 
+    // the cluster cache below this bus
+    void setCluster(ClusterCache *cache) { cluster = cache; }
+    // the cluster cache holds the block a grant was waiting for
+    void clusterAcquired();
+    // BusRd snoop to every cache, so none keeps the block exclusive
+    void clusterDowngrade(Addr addr);
+    // flush and drop the block from every cache
+    void clusterInvalidate(Addr addr);
+
+    // the shared LLC below this bus
+    void setLLC(SharedLLC *cache) { llc = cache; }
+    // for the LLC replacing a block held by one of the caches
+    bool canBackInvalidate(int cacheId, Addr addr);
+    void backInvalidate(int cacheId, Addr addr);
+    const std::map<int, CoherentCacheBase*> &caches() const {
+        return cacheMap;
+    }
+
     // // Methods for shared state tracking
     // bool hasShared(Addr addr) const { return sharedAddresses.find(addr) != sharedAddresses.end(); }
     // void setShared(Addr addr) { sharedAddresses.insert(addr); }
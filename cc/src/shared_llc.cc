@@ -0,0 +1,454 @@
+#include "src_740/shared_llc.hh"
+#include "src_740/coherent_cache_base.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/SBus.hh"
+
+#include <cstring>
+
+namespace gem5 {
+
+SharedLLC::SharedLLC(const SharedLLCParams &params)
+    : SimObject(params),
+      cpuPort(params.name + ".cpu_side", this),
+      memPort(params.name + ".mem_side", this),
+      bus(params.serializing_bus),
+      setBit(params.setBit),
+      assoc(params.assoc),
+      numBanks(params.num_banks),
+      tagLatency(params.tag_latency),
+      hitLatency(params.hit_latency),
+      bankOccupancy(params.bank_occupancy),
+      cacheableRanges(params.cacheable_ranges),
+      memReqEvent([this](){ processMemReq(); }, name()),
+      respEvent([this](){ processResp(); }, name()),
+      stats(this) {
+    fatal_if(assoc < 1, "%s: assoc must be at least 1", name());
+    fatal_if(numBanks < 1, "%s: num_banks must be at least 1", name());
+    numSets = 1 << setBit;
+    bankFreeAt.resize(numBanks, 0);
+    bus->setLLC(this);
+}
+
+SharedLLC::LLCStats::LLCStats(statistics::Group *parent)
+    : statistics::Group(parent),
+      ADD_STAT(hits, statistics::units::Count::get(),
+               "block fills served by the LLC"),
+      ADD_STAT(misses, statistics::units::Count::get(),
+               "block fills sent to memory"),
+      ADD_STAT(uncacheable, statistics::units::Count::get(),
+               "requests passed through to memory"),
+      ADD_STAT(bankConflicts, statistics::units::Count::get(),
+               "accesses that waited for a busy bank"),
+      ADD_STAT(replacements, statistics::units::Count::get(),
+               "valid lines replaced"),
+      ADD_STAT(backInvalidations, statistics::units::Count::get(),
+               "blocks invalidated in a cache above on a replacement"),
+      ADD_STAT(unallocatedFills, statistics::units::Count::get(),
+               "fills passed on without a line, every way of the set was "
+               "busy in a cluster"),
+      ADD_STAT(missRate, statistics::units::Ratio::get(),
+               "fraction of block fills that missed",
+               misses / (hits + misses)) {}
+
+void SharedLLC::init() {
+    if (!cpuPort.isConnected() || !memPort.isConnected()) {
+        panic("%s: both ports must be connected", name());
+    }
+    cpuPort.sendRangeChange();
+
+    blockSize = bus->cacheBlockSize;
+    blockOffset = 0;
+    while ((1 << blockOffset) < blockSize) {
+        blockOffset++;
+    }
+
+    lines.resize(numSets * assoc, llcLine{0, false, 0, 0});
+    data.resize((size_t)numSets * assoc * blockSize, 0);
+}
+
+void SharedLLC::startup() {
+    // the bus fills and filters snoops by the caches' ranges; a block they
+    // keep coherent but this LLC passed through would keep its pending
+    // sharers forever
+    for (auto &it : bus->caches()) {
+        fatal_if(it.second->cacheableRanges != cacheableRanges,
+                 "%s: cacheable_ranges differ from those of cache %d on "
+                 "the bus", name(), it.first);
+    }
+}
+
+Port &SharedLLC::getPort(const std::string &port_name, PortID idx) {
+    if (port_name == "cpu_side") {
+        return cpuPort;
+    } else if (port_name == "mem_side") {
+        return memPort;
+    }
+    return SimObject::getPort(port_name, idx);
+}
+
+bool SharedLLC::isCacheable(PacketPtr pkt) {
+    // the bus fills whole aligned blocks, everything else passes through
+    if (pkt->getSize() != blockSize ||
+        pkt->getAddr() != pkt->getBlockAddr(blockSize)) {
+        return false;
+    }
+    for (auto &range : cacheableRanges) {
+        if (range.contains(pkt->getAddr())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int SharedLLC::getSet(Addr blkAddr) {
+    return (blkAddr >> blockOffset) & (numSets - 1);
+}
+
+int SharedLLC::findLine(Addr blkAddr) {
+    auto it = lineMap.find(blkAddr);
+    return it == lineMap.end() ? -1 : it->second;
+}
+
+uint8_t *SharedLLC::lineData(int lineID) {
+    return &data[(size_t)lineID * blockSize];
+}
+
+int SharedLLC::allocate(Addr blkAddr) {
+    int first = getSet(blkAddr) * assoc;
+
+    // an invalid way, else the LRU way with no sharers, else the LRU way
+    // whose sharers can all drop the block now
+    int victim = -1;
+    int unshared = -1;
+    int shared = -1;
+    for (int lineID = first; lineID < first + assoc; lineID++) {
+        llcLine &line = lines[lineID];
+        if (!line.valid) {
+            victim = lineID;
+            break;
+        }
+        if (line.sharers == 0) {
+            if (unshared == -1 || line.lastUse < lines[unshared].lastUse) {
+                unshared = lineID;
+            }
+            continue;
+        }
+        bool evictable = true;
+        for (int id = 0; id < 64; id++) {
+            if ((line.sharers >> id & 1) &&
+                !bus->canBackInvalidate(id, line.blkAddr)) {
+                evictable = false;
+                break;
+            }
+        }
+        if (evictable &&
+            (shared == -1 || line.lastUse < lines[shared].lastUse)) {
+            shared = lineID;
+        }
+    }
+
+    if (victim == -1) {
+        victim = unshared != -1 ? unshared : shared;
+    }
+    if (victim == -1) {
+        // back invalidating now would break a cluster's transaction
+        return -1;
+    }
+
+    if (lines[victim].valid) {
+        replace(victim);
+    }
+
+    llcLine &line = lines[victim];
+    line.blkAddr = blkAddr;
+    line.valid = true;
+    line.sharers = 0;
+    line.lastUse = ++useCounter;
+    lineMap[blkAddr] = victim;
+    return victim;
+}
+
+void SharedLLC::replace(int lineID) {
+    llcLine &line = lines[lineID];
+    stats.replacements++;
+
+    // the caches' writebacks reach handleFunctional() while the line is
+    // still valid
+    for (int id = 0; id < 64; id++) {
+        if (line.sharers >> id & 1) {
+            DPRINTF(SBus, "LLC back invalidating %#x in %d\n\n",
+                    line.blkAddr, id);
+            stats.backInvalidations++;
+            bus->backInvalidate(id, line.blkAddr);
+        }
+    }
+
+    lineMap.erase(line.blkAddr);
+    line.valid = false;
+    line.sharers = 0;
+}
+
+bool SharedLLC::isSharer(Addr addr, int cacheId) {
+    Addr blkAddr = addr & ~(Addr)(blockSize - 1);
+    int lineID = findLine(blkAddr);
+    if (lineID != -1) {
+        return lines[lineID].sharers >> cacheId & 1;
+    }
+    // by inclusion only a cache the block is being filled for can hold it
+    auto it = pendingSharers.find(blkAddr);
+    return it != pendingSharers.end() && (it->second >> cacheId & 1);
+}
+
+void SharedLLC::addSharer(Addr addr, int cacheId) {
+    panic_if(cacheId < 0 || cacheId >= 64,
+             "%s: cache id %d does not fit the sharer bits", name(),
+             cacheId);
+    Addr blkAddr = addr & ~(Addr)(blockSize - 1);
+    int lineID = findLine(blkAddr);
+    if (lineID != -1) {
+        lines[lineID].sharers |= (uint64_t)1 << cacheId;
+    }
+    else {
+        pendingSharers[blkAddr] |= (uint64_t)1 << cacheId;
+    }
+}
+
+void SharedLLC::removeSharer(Addr addr, int cacheId) {
+    Addr blkAddr = addr & ~(Addr)(blockSize - 1);
+    int lineID = findLine(blkAddr);
+    if (lineID != -1) {
+        lines[lineID].sharers &= ~((uint64_t)1 << cacheId);
+        return;
+    }
+    auto it = pendingSharers.find(blkAddr);
+    if (it != pendingSharers.end()) {
+        it->second &= ~((uint64_t)1 << cacheId);
+        if (it->second == 0) {
+            pendingSharers.erase(it);
+        }
+    }
+}
+
+bool SharedLLC::handleRequest(PacketPtr pkt) {
+    if (!isCacheable(pkt)) {
+        stats.uncacheable++;
+        queueMemReq(pkt, curTick());
+        return true;
+    }
+
+    Addr blkAddr = pkt->getAddr();
+    assert(pkt->isRead());
+
+    int bank = (blkAddr >> blockOffset) % numBanks;
+    Tick start = std::max(curTick(), bankFreeAt[bank]);
+    if (start > curTick()) {
+        stats.bankConflicts++;
+    }
+    bankFreeAt[bank] = start + bankOccupancy;
+
+    int lineID = findLine(blkAddr);
+    if (lineID != -1) {
+        DPRINTF(SBus, "LLC hit %#x\n\n", blkAddr);
+        stats.hits++;
+        bus->energy.dataArrayRead();
+        lines[lineID].lastUse = ++useCounter;
+        pkt->makeResponse();
+        pkt->setDataFromBlock(lineData(lineID), blockSize);
+        queueResp(pkt, start + hitLatency);
+    }
+    else {
+        DPRINTF(SBus, "LLC miss %#x\n\n", blkAddr);
+        stats.misses++;
+        bus->energy.dramAccess();
+        fillPackets.insert(pkt);
+        queueMemReq(pkt, start + tagLatency);
+    }
+    return true;
+}
+
+bool SharedLLC::handleResponse(PacketPtr pkt) {
+    auto it = fillPackets.find(pkt);
+    if (it == fillPackets.end()) {
+        queueResp(pkt, curTick());
+        return true;
+    }
+    fillPackets.erase(it);
+
+    Addr blkAddr = pkt->getAddr();
+    int lineID = findLine(blkAddr);
+    if (lineID == -1) {
+        lineID = allocate(blkAddr);
+        if (lineID == -1) {
+            // the sharers stay pending until a later fill gets a line
+            stats.unallocatedFills++;
+            queueResp(pkt, curTick());
+            return true;
+        }
+        pkt->writeDataToBlock(lineData(lineID), blockSize);
+        bus->energy.dataArrayWrite();
+    }
+    else {
+        // filled by an earlier miss meanwhile, the line is the newer copy
+        pkt->setDataFromBlock(lineData(lineID), blockSize);
+    }
+
+    auto pending = pendingSharers.find(blkAddr);
+    if (pending != pendingSharers.end()) {
+        lines[lineID].sharers |= pending->second;
+        pendingSharers.erase(pending);
+    }
+
+    queueResp(pkt, curTick());
+    return true;
+}
+
+void SharedLLC::handleFunctional(PacketPtr pkt) {
+    Addr blkAddr = pkt->getBlockAddr(blockSize);
+    int lineID = findLine(blkAddr);
+    bool inBlock = pkt->getOffset(blockSize) + pkt->getSize() <=
+                   (unsigned)blockSize;
+
+    if (lineID != -1 && inBlock) {
+        if (pkt->isWrite()) {
+            // write through, memory stays up to date
+            pkt->writeDataToBlock(lineData(lineID), blockSize);
+            memPort.sendFunctional(pkt);
+        }
+        else {
+            pkt->setDataFromBlock(lineData(lineID), blockSize);
+        }
+        return;
+    }
+
+    panic_if(lineID != -1 && pkt->isWrite(),
+             "%s: functional write across blocks at %#x", name(),
+             pkt->getAddr());
+    memPort.sendFunctional(pkt);
+}
+
+void SharedLLC::queueMemReq(PacketPtr pkt, Tick when) {
+    auto pos = memReqQueue.end();
+    while (pos != memReqQueue.begin() && std::prev(pos)->second > when) {
+        pos--;
+    }
+    memReqQueue.insert(pos, std::make_pair(pkt, when));
+
+    if (memPort.blockedPacket == nullptr) {
+        if (memReqEvent.scheduled()) {
+            reschedule(memReqEvent,
+                       std::min(memReqEvent.when(),
+                                memReqQueue.front().second));
+        }
+        else {
+            schedule(memReqEvent, memReqQueue.front().second);
+        }
+    }
+}
+
+void SharedLLC::queueResp(PacketPtr pkt, Tick when) {
+    auto pos = respQueue.end();
+    while (pos != respQueue.begin() && std::prev(pos)->second > when) {
+        pos--;
+    }
+    respQueue.insert(pos, std::make_pair(pkt, when));
+
+    if (cpuPort.blockedPacket == nullptr) {
+        if (respEvent.scheduled()) {
+            reschedule(respEvent,
+                       std::min(respEvent.when(), respQueue.front().second));
+        }
+        else {
+            schedule(respEvent, respQueue.front().second);
+        }
+    }
+}
+
+void SharedLLC::processMemReq() {
+    // drain every request that is ready, recvReqRetry() resumes the drain
+    // while memory is busy
+    while (!memReqQueue.empty() && memReqQueue.front().second <= curTick() &&
+           memPort.blockedPacket == nullptr) {
+        PacketPtr pkt = memReqQueue.front().first;
+        memReqQueue.pop_front();
+        memPort.sendPacket(pkt);
+    }
+
+    if (!memReqQueue.empty() && memPort.blockedPacket == nullptr &&
+        !memReqEvent.scheduled()) {
+        schedule(memReqEvent,
+                 std::max(memReqQueue.front().second, curTick()));
+    }
+}
+
+void SharedLLC::processResp() {
+    while (!respQueue.empty() && respQueue.front().second <= curTick() &&
+           cpuPort.blockedPacket == nullptr) {
+        PacketPtr pkt = respQueue.front().first;
+        respQueue.pop_front();
+        cpuPort.sendPacket(pkt);
+    }
+
+    if (!respQueue.empty() && cpuPort.blockedPacket == nullptr &&
+        !respEvent.scheduled()) {
+        schedule(respEvent, std::max(respQueue.front().second, curTick()));
+    }
+}
+
+AddrRangeList SharedLLC::CpuSidePort::getAddrRanges() const {
+    return owner->memPort.getAddrRanges();
+}
+
+void SharedLLC::CpuSidePort::recvFunctional(PacketPtr pkt) {
+    owner->handleFunctional(pkt);
+}
+
+bool SharedLLC::CpuSidePort::recvTimingReq(PacketPtr pkt) {
+    return owner->handleRequest(pkt);
+}
+
+void SharedLLC::CpuSidePort::sendPacket(PacketPtr pkt) {
+    panic_if(blockedPacket != nullptr, "Should not try to send if blocked!");
+    if (!sendTimingResp(pkt)) {
+        blockedPacket = pkt;
+    }
+}
+
+void SharedLLC::CpuSidePort::recvRespRetry() {
+    assert(blockedPacket != nullptr);
+    PacketPtr pkt = blockedPacket;
+    blockedPacket = nullptr;
+
+    sendPacket(pkt);
+    if (blockedPacket == nullptr) {
+        owner->processResp();
+    }
+}
+
+void SharedLLC::MemSidePort::sendPacket(PacketPtr pkt) {
+    panic_if(blockedPacket != nullptr, "Should not try to send if blocked!");
+    if (!sendTimingReq(pkt)) {
+        blockedPacket = pkt;
+    }
+}
+
+bool SharedLLC::MemSidePort::recvTimingResp(PacketPtr pkt) {
+    return owner->handleResponse(pkt);
+}
+
+void SharedLLC::MemSidePort::recvReqRetry() {
+    assert(blockedPacket != nullptr);
+    PacketPtr pkt = blockedPacket;
+    blockedPacket = nullptr;
+
+    sendPacket(pkt);
+    if (blockedPacket == nullptr) {
+        owner->processMemReq();
+    }
+}
+
+void SharedLLC::MemSidePort::recvRangeChange() {
+    owner->cpuPort.sendRangeChange();
+}
+
+} // namespace gem5
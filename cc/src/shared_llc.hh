@@ -0,0 +1,160 @@
+#pragma once
+
+#include "base/statistics.hh"
+#include "mem/port.hh"
+#include "params/SharedLLC.hh"
+#include "sim/sim_object.hh"
+
+#include "src_740/serializing_bus.hh"
+
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace gem5 {
+
+// Shared last level cache between a SerializingBus and the memory bus. It
+// is set associative with LRU replacement, split into banks by block
+// address, and inclusive of every cache on the bus: each line keeps a
+// sharer bit per cache id, the bus only snoops the caches whose bit is set,
+// and a line is back invalidated in its sharers before it is replaced.
+// A fill whose set has no way that can be replaced now is passed on
+// without a line; its sharers stay pending, so the bus keeps snooping
+// them.
+// The caches write back functionally, so writebacks update the line and
+// memory together; lines are never dirty and a replacement only needs the
+// back invalidation.
+class SharedLLC : public SimObject {
+   public:
+    class CpuSidePort : public ResponsePort {
+       public:
+        SharedLLC *owner;
+        PacketPtr blockedPacket = nullptr;
+
+        CpuSidePort(const std::string &name, SharedLLC *owner)
+            : ResponsePort(name, owner), owner(owner) {}
+
+        AddrRangeList getAddrRanges() const override;
+        void sendPacket(PacketPtr pkt);
+
+        Tick recvAtomic(PacketPtr pkt) override { panic("recvAtomic unimpl."); }
+        void recvFunctional(PacketPtr pkt) override;
+        bool recvTimingReq(PacketPtr pkt) override;
+        void recvRespRetry() override;
+    };
+
+    class MemSidePort : public RequestPort {
+       public:
+        SharedLLC *owner;
+        PacketPtr blockedPacket = nullptr;
+
+        MemSidePort(const std::string &name, SharedLLC *owner)
+            : RequestPort(name, owner), owner(owner) {}
+
+        void sendPacket(PacketPtr pkt);
+
+        bool recvTimingResp(PacketPtr pkt) override;
+        void recvReqRetry() override;
+        void recvRangeChange() override;
+    };
+
+    typedef struct LLCLine{
+        Addr blkAddr;
+        bool valid;
+        // one bit per cache id on the bus that may hold the block
+        uint64_t sharers;
+        // for LRU replacement
+        uint64_t lastUse;
+    } llcLine;
+
+    struct LLCStats : public statistics::Group {
+        LLCStats(statistics::Group *parent);
+
+        statistics::Scalar hits;
+        statistics::Scalar misses;
+        statistics::Scalar uncacheable;
+        statistics::Scalar bankConflicts;
+        statistics::Scalar replacements;
+        statistics::Scalar backInvalidations;
+        statistics::Scalar unallocatedFills;
+        statistics::Formula missRate;
+    };
+
+    CpuSidePort cpuPort;
+    MemSidePort memPort;
+
+    // bus whose caches this LLC includes
+    SerializingBus *bus;
+
+    // taken from the bus in init(), the L1s set it when they are built
+    int blockSize = 32;
+    int blockOffset = 5;
+
+    int setBit;
+    int numSets;
+    int assoc;
+
+    int numBanks;
+    Tick tagLatency;
+    Tick hitLatency;
+    Tick bankOccupancy;
+
+    std::vector<AddrRange> cacheableRanges;
+
+    // numSets * assoc lines, set by set, and their data
+    std::vector<llcLine> lines;
+    std::vector<uint8_t> data;
+    // block address to line index
+    std::unordered_map<Addr, int> lineMap;
+    uint64_t useCounter = 0;
+
+    // tick each bank is done with its current access
+    std::vector<Tick> bankFreeAt;
+
+    // bus packets sent to memory because they missed
+    std::unordered_set<PacketPtr> fillPackets;
+    // sharers of blocks that are being filled, or that were filled
+    // without a line
+    std::unordered_map<Addr, uint64_t> pendingSharers;
+
+    // (packet, tick it is ready), in order of the ready tick per queue
+    std::list<std::pair<PacketPtr, Tick>> memReqQueue;
+    std::list<std::pair<PacketPtr, Tick>> respQueue;
+    EventFunctionWrapper memReqEvent;
+    EventFunctionWrapper respEvent;
+
+    LLCStats stats;
+
+    SharedLLC(const SharedLLCParams &params);
+
+    void init() override;
+    void startup() override;
+
+    Port &getPort(const std::string &port_name,
+                  PortID idx = InvalidPortID) override;
+
+    bool isCacheable(PacketPtr pkt);
+    int getSet(Addr blkAddr);
+    int findLine(Addr blkAddr);
+    uint8_t *lineData(int lineID);
+    // line for blkAddr, -1 if no way of its set can be replaced now
+    int allocate(Addr blkAddr);
+    void replace(int lineID);
+
+    // directory interface for the bus
+    bool isSharer(Addr addr, int cacheId);
+    void addSharer(Addr addr, int cacheId);
+    void removeSharer(Addr addr, int cacheId);
+
+    bool handleRequest(PacketPtr pkt);
+    bool handleResponse(PacketPtr pkt);
+    void handleFunctional(PacketPtr pkt);
+
+    void queueMemReq(PacketPtr pkt, Tick when);
+    void queueResp(PacketPtr pkt, Tick when);
+    void processMemReq();
+    void processResp();
+};
+
+}
@@ -0,0 +1,180 @@
+#include "src_740/sharing_profiler.hh"
+#include "base/logging.hh"
+
+#include <algorithm>
+#include <bitset>
+#include <iomanip>
+
+namespace gem5 {
+
+void SharingProfiler::init(unsigned blockSize) {
+    fatal_if(blockSize == 0 || blockSize > 64 ||
+             (blockSize & (blockSize - 1)) != 0,
+             "sharing profiler needs power of two blocks of at most 64 "
+             "bytes, got %d", blockSize);
+    this->blockSize = blockSize;
+}
+
+void SharingProfiler::endWriteRun(BlockProfile &block) {
+    if (block.currRun == 0) {
+        return;
+    }
+    block.numRuns++;
+    block.totalRunLength += block.currRun;
+    block.maxRun = std::max(block.maxRun, block.currRun);
+    block.currRun = 0;
+}
+
+void SharingProfiler::recordAccess(int core, Addr addr, unsigned size,
+                                   bool isWrite) {
+    panic_if(core < 0 || core >= 64, "sharing profiler tracks 64 cores");
+    BlockProfile &block = blocks[blockAddr(addr)];
+
+    unsigned offset = addr - blockAddr(addr);
+    unsigned bytes = std::min(size, blockSize - offset);
+    uint64_t mask = (bytes >= 64 ? ~0ULL : ((1ULL << bytes) - 1)) << offset;
+
+    // any access by another core ends the current write run
+    if (block.lastAccessor != core) {
+        endWriteRun(block);
+    }
+
+    CoreAccess &access = block.cores[core];
+    if (isWrite) {
+        if (block.lastWriter != -1 && block.lastWriter != core) {
+            block.writerHandoffs++;
+            if (block.lastAccessor == core && block.lastAccessWasRead) {
+                block.migratoryHandoffs++;
+            }
+        }
+        block.writes++;
+        block.writers |= 1ULL << core;
+        block.lastWriter = core;
+        block.currRun++;
+        access.writeMask |= mask;
+    }
+    else {
+        block.reads++;
+        block.readers |= 1ULL << core;
+        access.readMask |= mask;
+    }
+    block.lastAccessor = core;
+    block.lastAccessWasRead = !isWrite;
+}
+
+void SharingProfiler::recordTransaction(Addr addr) {
+    blocks[blockAddr(addr)].busTransactions++;
+}
+
+SharingClass SharingProfiler::classify(const BlockProfile &block) {
+    if (block.cores.size() <= 1) {
+        return SharingPrivate;
+    }
+    if (block.writers == 0) {
+        return SharingReadShared;
+    }
+
+    // no byte written by one core is touched by any other core
+    bool disjoint = true;
+    for (auto &writer : block.cores) {
+        if (writer.second.writeMask == 0) {
+            continue;
+        }
+        for (auto &other : block.cores) {
+            if (other.first != writer.first &&
+                (writer.second.writeMask &
+                 (other.second.readMask | other.second.writeMask))) {
+                disjoint = false;
+            }
+        }
+    }
+    if (disjoint) {
+        return SharingFalseShared;
+    }
+
+    if (std::bitset<64>(block.writers).count() == 1) {
+        return SharingProducerConsumer;
+    }
+    if (block.writerHandoffs > 0 &&
+        block.migratoryHandoffs * 2 >= block.writerHandoffs) {
+        return SharingMigratory;
+    }
+    return SharingWriteShared;
+}
+
+const char *SharingProfiler::className(SharingClass cls) {
+    static const char *names[NumSharingClasses] = {
+        "private", "read-shared", "producer-consumer", "migratory",
+        "false-shared", "write-shared"
+    };
+    return names[cls];
+}
+
+void SharingProfiler::dump(std::ostream &os) {
+    std::vector<std::pair<Addr, BlockProfile *>> ranked;
+    for (auto &it : blocks) {
+        endWriteRun(it.second);
+        ranked.emplace_back(it.first, &it.second);
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const std::pair<Addr, BlockProfile *> &a,
+                 const std::pair<Addr, BlockProfile *> &b) {
+                  if (a.second->busTransactions != b.second->busTransactions) {
+                      return a.second->busTransactions >
+                             b.second->busTransactions;
+                  }
+                  return a.first < b.first;
+              });
+
+    uint64_t classBlocks[NumSharingClasses] = {};
+    uint64_t classTrans[NumSharingClasses] = {};
+    for (auto &it : ranked) {
+        SharingClass cls = classify(*it.second);
+        classBlocks[cls]++;
+        classTrans[cls] += it.second->busTransactions;
+    }
+
+    os << "# sharing profile, " << blockSize << " byte blocks\n";
+    os << "# class                blocks   bus transactions\n";
+    for (int cls = 0; cls < NumSharingClasses; cls++) {
+        os << "# " << std::left << std::setw(18)
+           << className((SharingClass)cls) << std::right
+           << std::setw(10) << classBlocks[cls]
+           << std::setw(19) << classTrans[cls] << "\n";
+    }
+    os << "#\n# block class busTrans reads writes readers writers writeRuns "
+       << "avgWriteRun maxWriteRun bytesWritten(core:mask)...\n";
+
+    for (auto &it : ranked) {
+        const BlockProfile &block = *it.second;
+        os << std::hex << std::showbase << it.first << std::dec
+           << std::noshowbase
+           << " " << className(classify(block))
+           << " " << block.busTransactions
+           << " " << block.reads
+           << " " << block.writes
+           << " " << std::bitset<64>(block.readers).count()
+           << " " << std::bitset<64>(block.writers).count()
+           << " " << block.numRuns
+           << " " << std::fixed << std::setprecision(2)
+           << (block.numRuns ? (double)block.totalRunLength / block.numRuns
+                             : 0.0)
+           << " " << block.maxRun;
+
+        std::vector<int> coreIds;
+        for (auto &core : block.cores) {
+            if (core.second.writeMask) {
+                coreIds.push_back(core.first);
+            }
+        }
+        std::sort(coreIds.begin(), coreIds.end());
+        for (int core : coreIds) {
+            os << " " << core << ":" << std::hex << std::setw(blockSize / 4)
+               << std::setfill('0') << block.cores.at(core).writeMask
+               << std::setfill(' ') << std::dec;
+        }
+        os << "\n";
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "base/types.hh"
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace gem5 {
+
+// How a block was shared over the whole run
+enum SharingClass {
+    SharingPrivate = 0,       // one core only
+    SharingReadShared,        // several readers, never written
+    SharingProducerConsumer,  // one writer, other cores read
+    SharingMigratory,         // cores take turns reading then writing it
+    SharingFalseShared,       // cores write bytes no other core touches
+    SharingWriteShared,       // several writers of the same bytes
+    NumSharingClasses
+};
+
+// Per block sharing profile, fed by the caches' cpu accesses and the bus
+// transactions. Byte masks are 64 bits wide, so blocks up to 64 bytes.
+class SharingProfiler {
+   public:
+    typedef struct CoreAccess {
+        uint64_t readMask = 0;
+        uint64_t writeMask = 0;
+    } CoreAccess;
+
+    typedef struct BlockProfile {
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        uint64_t busTransactions = 0;
+
+        // bit i set if core i read / wrote the block
+        uint64_t readers = 0;
+        uint64_t writers = 0;
+
+        // consecutive writes by one core with no other core in between
+        int lastAccessor = -1;
+        bool lastAccessWasRead = false;
+        int lastWriter = -1;
+        uint64_t currRun = 0;
+        uint64_t numRuns = 0;
+        uint64_t totalRunLength = 0;
+        uint64_t maxRun = 0;
+
+        // writes that took the block from another writer, and those where
+        // the new writer had just read it (read-modify-write migration)
+        uint64_t writerHandoffs = 0;
+        uint64_t migratoryHandoffs = 0;
+
+        // bytes touched by each core
+        std::unordered_map<int, CoreAccess> cores;
+    } BlockProfile;
+
+    void init(unsigned blockSize);
+
+    void recordAccess(int core, Addr addr, unsigned size, bool isWrite);
+    void recordTransaction(Addr addr);
+
+    static SharingClass classify(const BlockProfile &block);
+    static const char *className(SharingClass cls);
+
+    // blocks ranked by bus transactions, with a per class summary
+    void dump(std::ostream &os);
+
+   private:
+    unsigned blockSize = 0;
+    std::unordered_map<Addr, BlockProfile> blocks;
+
+    Addr blockAddr(Addr addr) const { return addr & ~(Addr)(blockSize - 1); }
+    static void endWriteRun(BlockProfile &block);
+};
+
+}
@@ -0,0 +1,578 @@
+#include "coherence_model.hh"
+
+#include <cassert>
+
+namespace tracesim {
+
+#define NOT_EXIST (-1)
+
+static inline bool hasBusRd(BusOperationType op) { return op & BusRd; }
+static inline bool hasBusUpd(BusOperationType op) { return op & BusUpd; }
+
+const char* protocolName(Protocol protocol) {
+    switch (protocol) {
+        case Protocol::Mesi: return "mesi";
+        case Protocol::Dragon: return "dragon";
+        case Protocol::Hybrid: return "hybrid";
+        case Protocol::Adapt: return "adapt";
+    }
+    return "unknown";
+}
+
+bool parseProtocol(const std::string &name, Protocol &protocol) {
+    for (Protocol p : {Protocol::Mesi, Protocol::Dragon, Protocol::Hybrid,
+                       Protocol::Adapt}) {
+        if (name == protocolName(p)) {
+            protocol = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ModelBus::broadcast(int originator, uint64_t addr, bool isWrite,
+                         BusOperationType op) {
+    for (auto &cache : caches) {
+        if (cache->cacheId == originator) {
+            continue;
+        }
+        int fromState = cache->getCohState(addr);
+        cache->snoop(addr, isWrite, op);
+        int toState = cache->getCohState(addr);
+        if (fromState != toState) {
+            cache->stats.snoopTransitions++;
+            if (toState == INVALID) {
+                cache->stats.invalidations++;
+            }
+        }
+    }
+}
+
+void ModelBus::statsUpdate(BusOperationType op, int dataSize) {
+    switch (op) {
+        case BusRdX:
+            stats.rdxCount++;
+            stats.transCount++;
+            break;
+        case BusRd:
+            stats.rdCount++;
+            stats.transCount++;
+            break;
+        case BusUpd:
+            stats.updCount++;
+            stats.transCount++;
+            stats.updBytes += dataSize;
+            break;
+        case BusRdUpd:
+            stats.updCount++;
+            stats.rdCount++;
+            stats.transCount += 2;
+            stats.updBytes += dataSize;
+            break;
+    }
+}
+
+ModelCache::ModelCache(int cacheId, const ModelParams &params, ModelBus &bus)
+    : cacheId(cacheId),
+      bus(bus),
+      blockOffset(params.blockOffset),
+      setBit(params.setBit),
+      invalidThreshold(params.invalidThreshold),
+      invalidationRatio(params.invalidationRatio),
+      sharedStart(params.sharedStart) {
+    blockSize = 0x1 << blockOffset;
+    numSets = 0x1 << setBit;
+    cacheSize = 0x1 << params.cacheSizeBit;
+    numLines = cacheSize / numSets / blockSize;
+    assert(numLines > 0);
+
+    cacheMgr.resize(numSets);
+    for (auto &setMgr : cacheMgr) {
+        setMgr.cacheSet.resize(numLines);
+        for (auto &cline : setMgr.cacheSet) {
+            cline.invalidCounter = invalidThreshold;
+        }
+    }
+}
+
+uint64_t ModelCache::getTag(uint64_t addr) const {
+    return addr >> (blockOffset + setBit);
+}
+
+uint64_t ModelCache::getSet(uint64_t addr) const {
+    uint64_t mask = (0x1 << (blockOffset + setBit)) - 1;
+    return (addr & mask) >> blockOffset;
+}
+
+bool ModelCache::isFullBlock(uint64_t addr, int size) const {
+    return ((addr >> blockOffset) << blockOffset) == addr &&
+           size == blockSize;
+}
+
+bool ModelCache::isHit(uint64_t addr, int &lineID) {
+    // an invalid line can still be present in the tag map
+    cacheSetMgr &setMgr = cacheMgr[getSet(addr)];
+    auto it = setMgr.tagMap.find(getTag(addr));
+    if (it == setMgr.tagMap.end()) {
+        lineID = NOT_EXIST;
+        return false;
+    }
+    lineID = it->second;
+    return setMgr.cacheSet[lineID].cohState != INVALID;
+}
+
+int ModelCache::getCohState(uint64_t addr) {
+    int lineID;
+    if (!isHit(addr, lineID)) {
+        return INVALID;
+    }
+    return lineAt(addr, lineID).cohState;
+}
+
+ModelCache::CacheLine &ModelCache::lineAt(uint64_t addr, int lineID) {
+    return cacheMgr[getSet(addr)].cacheSet[lineID];
+}
+
+int ModelCache::allocate(uint64_t addr) {
+    // evict() left the clock pointer on a free line
+    cacheSetMgr &setMgr = cacheMgr[getSet(addr)];
+    uint64_t tag = getTag(addr);
+
+    CacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
+    assert(!cline.valid);
+    cline.dirty = false;
+    cline.clkFlag = true;
+    cline.cohState = INVALID;
+    cline.valid = true;
+    cline.tag = tag;
+    cline.accessSinceUpd = false;
+    cline.invalidCounter = invalidThreshold;
+    onAllocate(addr, cline);
+
+    int lineID = setMgr.clkPtr;
+    setMgr.tagMap[tag] = lineID;
+    setMgr.clkPtr = (setMgr.clkPtr + 1) % numLines;
+    return lineID;
+}
+
+void ModelCache::evict(uint64_t addr) {
+    cacheSetMgr &setMgr = cacheMgr[getSet(addr)];
+
+    if ((int)setMgr.tagMap.size() < numLines) {
+        // still have unallocated lines
+        return;
+    }
+
+    while (true) {
+        CacheLine &cline = setMgr.cacheSet[setMgr.clkPtr];
+        if (cline.clkFlag) {
+            cline.clkFlag = false;
+        }
+        else {
+            stats.evictions++;
+            if (cline.dirty) {
+                bus.stats.writebacks++;
+            }
+            setMgr.tagMap.erase(cline.tag);
+            onEvict(addr, cline);
+            cline.valid = false;
+            break;
+        }
+        setMgr.clkPtr = (setMgr.clkPtr + 1) % numLines;
+    }
+}
+
+void ModelCache::flush() {
+    // a snooped owner supplies the whole block
+    bus.stats.rdBytes += blockSize;
+}
+
+AccessResult MesiModel::access(uint64_t addr, int size, bool isWrite) {
+    int lineID;
+    bool cacheHit = isHit(addr, lineID);
+
+    if (cacheHit) {
+        stats.hitCount++;
+        CacheLine &cline = lineAt(addr, lineID);
+        cline.clkFlag = true;
+        if (!isWrite) {
+            return {false, false};
+        }
+        if (cline.cohState != Shared) {
+            // E or M, silent upgrade
+            cline.cohState = Modified;
+            cline.dirty = true;
+            return {false, false};
+        }
+        // S needs ownership but no data
+        bus.sharedWire = false;
+        bus.broadcast(cacheId, addr, true, BusRdX);
+        bus.statsUpdate(BusRdX, size);
+        cline.cohState = Modified;
+        cline.dirty = true;
+        return {true, false};
+    }
+
+    stats.missCount++;
+    BusOperationType op = isWrite ? BusRdX : BusRd;
+    // a full block write does not need the old data
+    bool memFetch = !isWrite || !isFullBlock(addr, size);
+
+    bus.sharedWire = false;
+    bus.broadcast(cacheId, addr, isWrite, op);
+    bus.statsUpdate(op, size);
+
+    if (lineID == NOT_EXIST) {
+        evict(addr);
+        lineID = allocate(addr);
+    }
+    CacheLine &cline = lineAt(addr, lineID);
+    cline.clkFlag = true;
+    if (isWrite) {
+        cline.cohState = Modified;
+        cline.dirty = true;
+    }
+    else {
+        cline.cohState = bus.sharedWire ? Shared : Exclusive;
+    }
+    return {true, memFetch};
+}
+
+void MesiModel::snoop(uint64_t addr, bool isWrite, BusOperationType op) {
+    int lineID;
+    if (!isHit(addr, lineID)) {
+        return;
+    }
+    bus.sharedWire = true;
+
+    CacheLine &cline = lineAt(addr, lineID);
+    bool isRemoteRead = !isWrite;
+    switch (cline.cohState) {
+        case Modified:
+            flush();
+            cline.dirty = false;
+            cline.cohState = isRemoteRead ? Shared : Invalid;
+            break;
+        case Exclusive:
+        case Shared:
+            cline.cohState = isRemoteRead ? Shared : Invalid;
+            break;
+        default:
+            break;
+    }
+}
+
+AccessResult DragonModel::access(uint64_t addr, int size, bool isWrite) {
+    int lineID;
+    bool cacheHit = isHit(addr, lineID);
+
+    if (cacheHit) {
+        stats.hitCount++;
+        CacheLine &cline = lineAt(addr, lineID);
+        cline.clkFlag = true;
+        if (!isWrite) {
+            return {false, false};
+        }
+        if (cline.cohState == EXCLUSIVE || cline.cohState == MODIFIED) {
+            cline.cohState = MODIFIED;
+            cline.dirty = true;
+            return {false, false};
+        }
+        // Sc or Sm, push the written bytes to the sharers
+        bus.sharedWire = false;
+        bus.broadcast(cacheId, addr, true, BusUpd);
+        bus.statsUpdate(BusUpd, size);
+        cline.cohState = bus.sharedWire ? SHARED_MOD : MODIFIED;
+        cline.dirty = true;
+        return {true, false};
+    }
+
+    stats.missCount++;
+    BusOperationType op = isWrite ? BusRdUpd : BusRd;
+    bool memFetch = !isWrite || !isFullBlock(addr, size);
+
+    bus.sharedWire = false;
+    bus.broadcast(cacheId, addr, isWrite, op);
+    bus.statsUpdate(op, size);
+
+    if (lineID == NOT_EXIST) {
+        evict(addr);
+        lineID = allocate(addr);
+    }
+    CacheLine &cline = lineAt(addr, lineID);
+    cline.clkFlag = true;
+    if (isWrite) {
+        cline.cohState = bus.sharedWire ? SHARED_MOD : MODIFIED;
+        cline.dirty = true;
+    }
+    else {
+        cline.cohState = bus.sharedWire ? SHARED_CLEAN : EXCLUSIVE;
+    }
+    return {true, memFetch};
+}
+
+void DragonModel::snoop(uint64_t addr, bool isWrite, BusOperationType op) {
+    int lineID;
+    if (!isHit(addr, lineID)) {
+        return;
+    }
+    bus.sharedWire = true;
+
+    CacheLine &cline = lineAt(addr, lineID);
+    switch (cline.cohState) {
+        case MODIFIED:
+            flush();
+            cline.cohState = SHARED_MOD;
+            cline.dirty = false;
+            if (!hasBusUpd(op)) {
+                break;
+            }
+            // fall through, the update makes the line clean
+        case SHARED_MOD:
+            if (hasBusRd(op) && cline.dirty) {
+                flush();
+            }
+            if (hasBusUpd(op)) {
+                cline.cohState = SHARED_CLEAN;
+                cline.dirty = false;
+            }
+            break;
+        case EXCLUSIVE:
+            cline.cohState = SHARED_CLEAN;
+            break;
+        default:
+            // Sc only takes the updated bytes
+            break;
+    }
+}
+
+HybridModel::HybridModel(int cacheId, const ModelParams &params,
+                         ModelBus &bus, bool adaptive)
+    : ModelCache(cacheId, params, bus), adaptive(adaptive) {
+    if (adaptive && bus.invalidationThs.empty()) {
+        bus.invalidationThs.assign(
+            (params.sharedEnd - params.sharedStart) / blockSize,
+            invalidThreshold);
+    }
+}
+
+uint64_t HybridModel::getBlkNumber(uint64_t addr) const {
+    return (addr >> blockOffset) - (sharedStart >> blockOffset);
+}
+
+int HybridModel::blockThreshold(uint64_t addr) const {
+    return adaptive ? bus.invalidationThs[getBlkNumber(addr)]
+                    : invalidThreshold;
+}
+
+void HybridModel::endWriteRun(uint64_t addr, int &currWriteRun) {
+    if (currWriteRun < invalidationRatio) {
+        bus.invalidationThs[getBlkNumber(addr)]++;
+    }
+    else {
+        bus.invalidationThs[getBlkNumber(addr)]--;
+    }
+    currWriteRun = 0;
+}
+
+void HybridModel::onAllocate(uint64_t addr, CacheLine &line) {
+    line.invalidCounter = blockThreshold(addr);
+    line.writeRunCounter = 0;
+}
+
+void HybridModel::onEvict(uint64_t addr, CacheLine &line) {
+    if (adaptive) {
+        // AdaptCache::evict charges the run to the incoming block
+        endWriteRun(addr, line.writeRunCounter);
+    }
+}
+
+AccessResult HybridModel::access(uint64_t addr, int size, bool isWrite) {
+    int lineID;
+    bool cacheHit = isHit(addr, lineID);
+
+    if (cacheHit) {
+        stats.hitCount++;
+        CacheLine &cline = lineAt(addr, lineID);
+        cline.clkFlag = true;
+        if (!isWrite) {
+            cline.accessSinceUpd = true;
+            return {false, false};
+        }
+        if (cline.cohState == EXCLUSIVE || cline.cohState == MODIFIED) {
+            cline.cohState = MODIFIED;
+            cline.dirty = true;
+            if (adaptive) {
+                cline.writeRunCounter++;
+            }
+            return {false, false};
+        }
+
+        // Sc or Sm, update while the counter lasts, then invalidate
+        BusOperationType op = cline.invalidCounter > 0 ? BusUpd : BusRdX;
+        bus.sharedWire = false;
+        bus.remoteAccessWire = false;
+        bus.broadcast(cacheId, addr, true, op);
+        bus.statsUpdate(op, size);
+
+        if (cline.cohState == SHARED_CLEAN) {
+            if (adaptive) {
+                cline.writeRunCounter++;
+            }
+            if (bus.sharedWire) {
+                cline.invalidCounter--;
+            }
+        }
+        else if (bus.sharedWire) {
+            if (bus.remoteAccessWire) {
+                // a sharer read the block since our last update
+                if (adaptive) {
+                    endWriteRun(addr, cline.writeRunCounter);
+                }
+                cline.invalidCounter = blockThreshold(addr);
+            }
+            cline.invalidCounter--;
+            if (adaptive) {
+                cline.writeRunCounter++;
+            }
+        }
+        else {
+            cline.invalidCounter = blockThreshold(addr);
+            if (adaptive) {
+                cline.writeRunCounter++;
+            }
+        }
+        cline.cohState = bus.sharedWire ? SHARED_MOD : MODIFIED;
+        cline.dirty = true;
+        return {true, false};
+    }
+
+    stats.missCount++;
+    BusOperationType op = BusRd;
+    if (isWrite) {
+        op = blockThreshold(addr) > 0 ? BusRdUpd : BusRdX;
+    }
+    bool memFetch = !isWrite || !isFullBlock(addr, size);
+
+    bus.sharedWire = false;
+    bus.remoteAccessWire = false;
+    bus.broadcast(cacheId, addr, isWrite, op);
+    bus.statsUpdate(op, size);
+
+    if (lineID == NOT_EXIST) {
+        evict(addr);
+        lineID = allocate(addr);
+    }
+    CacheLine &cline = lineAt(addr, lineID);
+    cline.clkFlag = true;
+    if (isWrite) {
+        cline.dirty = true;
+        if (adaptive) {
+            cline.writeRunCounter++;
+        }
+        if (bus.sharedWire) {
+            cline.cohState = SHARED_MOD;
+            cline.invalidCounter--;
+        }
+        else {
+            cline.cohState = MODIFIED;
+        }
+    }
+    else {
+        cline.cohState = bus.sharedWire ? SHARED_CLEAN : EXCLUSIVE;
+    }
+    return {true, memFetch};
+}
+
+void HybridModel::snoop(uint64_t addr, bool isWrite, BusOperationType op) {
+    int lineID;
+    if (!isHit(addr, lineID)) {
+        return;
+    }
+    CacheLine &cline = lineAt(addr, lineID);
+    bus.sharedWire = (op != BusRdX);
+    bus.remoteAccessWire = cline.accessSinceUpd;
+
+    switch (cline.cohState) {
+        case MODIFIED:
+            flush();
+            cline.dirty = false;
+            if (adaptive) {
+                endWriteRun(addr, cline.writeRunCounter);
+            }
+            if (op == BusRdX) {
+                cline.cohState = INVALID;
+                break;
+            }
+            cline.cohState = SHARED_MOD;
+            if (!hasBusUpd(op)) {
+                break;
+            }
+            // fall through
+        case SHARED_MOD:
+            if (op != BusRdX) {
+                if (hasBusRd(op) && cline.dirty) {
+                    flush();
+                    cline.dirty = false;
+                }
+                if (hasBusUpd(op)) {
+                    cline.cohState = SHARED_CLEAN;
+                    cline.dirty = false;
+                    cline.accessSinceUpd = false;
+                }
+            }
+            else {
+                if (cline.dirty) {
+                    flush();
+                }
+                cline.cohState = INVALID;
+            }
+            if (adaptive && cline.writeRunCounter > 0) {
+                endWriteRun(addr, cline.writeRunCounter);
+            }
+            cline.invalidCounter = blockThreshold(addr);
+            break;
+        case EXCLUSIVE:
+            if (op == BusRdX) {
+                cline.cohState = INVALID;
+                break;
+            }
+            cline.cohState = SHARED_CLEAN;
+            if (!hasBusUpd(op)) {
+                break;
+            }
+            // fall through
+        case SHARED_CLEAN:
+            if (op == BusRdX) {
+                cline.cohState = INVALID;
+            }
+            else if (hasBusUpd(op)) {
+                cline.accessSinceUpd = false;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::unique_ptr<ModelCache> makeCache(Protocol protocol, int cacheId,
+                                      const ModelParams &params,
+                                      ModelBus &bus) {
+    switch (protocol) {
+        case Protocol::Mesi:
+            return std::unique_ptr<ModelCache>(
+                new MesiModel(cacheId, params, bus));
+        case Protocol::Dragon:
+            return std::unique_ptr<ModelCache>(
+                new DragonModel(cacheId, params, bus));
+        case Protocol::Hybrid:
+            return std::unique_ptr<ModelCache>(
+                new HybridModel(cacheId, params, bus, false));
+        case Protocol::Adapt:
+            return std::unique_ptr<ModelCache>(
+                new HybridModel(cacheId, params, bus, true));
+    }
+    return nullptr;
+}
+
+}
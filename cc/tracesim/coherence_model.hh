@@ -0,0 +1,206 @@
+#pragma once
+
+// Standalone models of the cc/src coherence protocols. Each model follows
+// the state machine of its gem5 counterpart (MesiCache, DragonCache,
+// HybridCache, AdaptCache) transition for transition, but performs a whole
+// cpu access atomically against ModelBus and keeps no data, so traces can
+// be replayed without gem5.
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesim {
+
+// same encoding as gem5::BusOperationType
+enum BusOperationType {
+    BusRdX = 0,
+    BusRd = 1,
+    BusUpd = 2,
+    BusRdUpd = 3
+};
+
+enum class Protocol {
+    Mesi,
+    Dragon,
+    Hybrid,
+    Adapt
+};
+
+const char* protocolName(Protocol protocol);
+bool parseProtocol(const std::string &name, Protocol &protocol);
+
+// the subset of CoherentCache.py parameters the protocols read
+typedef struct ModelParams {
+    int blockOffset = 5;
+    int setBit = 4;
+    int cacheSizeBit = 15;
+    int invalidThreshold = 5;
+    int invalidationRatio = 2;
+    // shared region covered by AdaptCache's per-block thresholds
+    uint64_t sharedStart = 0x8000;
+    uint64_t sharedEnd = 0xa000;
+} ModelParams;
+
+typedef struct BusStats {
+    uint64_t transCount = 0;
+    uint64_t rdxCount = 0;
+    uint64_t rdCount = 0;
+    uint64_t updCount = 0;
+    uint64_t rdBytes = 0;
+    uint64_t updBytes = 0;
+    // dirty victims written back on replacement
+    uint64_t writebacks = 0;
+} BusStats;
+
+typedef struct CacheStats {
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+    // coherence state changes made by cpu accesses and by snoops
+    uint64_t prTransitions = 0;
+    uint64_t snoopTransitions = 0;
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;
+} CacheStats;
+
+// what a single cpu access needed from the interconnect
+typedef struct AccessResult {
+    bool usedBus;
+    bool memFetch;
+} AccessResult;
+
+class ModelCache;
+
+class ModelBus {
+public:
+    std::vector<std::unique_ptr<ModelCache>> caches;
+
+    bool sharedWire = false;
+    bool remoteAccessWire = false;
+
+    // AdaptCache's per-block invalidation thresholds
+    std::vector<int> invalidationThs;
+
+    BusStats stats;
+
+    // snoop every cache except the originator
+    void broadcast(int originator, uint64_t addr, bool isWrite,
+                   BusOperationType op);
+
+    // same accounting as CoherentCacheBase::busStatsUpdate
+    void statsUpdate(BusOperationType op, int dataSize);
+};
+
+class ModelCache {
+public:
+    typedef struct CacheLine {
+        uint64_t tag = 0;
+        int cohState = 0;
+        bool dirty = false;
+        bool clkFlag = false;
+        bool valid = false;
+        bool accessSinceUpd = false;
+        int invalidCounter = 0;
+        int writeRunCounter = 0;
+    } cacheLine;
+
+    typedef struct CacheSetMgr {
+        std::vector<CacheLine> cacheSet;
+        std::unordered_map<uint64_t, int> tagMap;
+        int clkPtr = 0;
+    } cacheSetMgr;
+
+    ModelCache(int cacheId, const ModelParams &params, ModelBus &bus);
+    virtual ~ModelCache() {}
+
+    virtual AccessResult access(uint64_t addr, int size, bool isWrite) = 0;
+    virtual void snoop(uint64_t addr, bool isWrite, BusOperationType op) = 0;
+
+    // state of the line holding addr, 0 (invalid) if absent
+    int getCohState(uint64_t addr);
+
+    int cacheId;
+    ModelBus &bus;
+    CacheStats stats;
+
+protected:
+    int blockOffset;
+    int blockSize;
+    int setBit;
+    int numSets;
+    int cacheSize;
+    int numLines;
+    int invalidThreshold;
+    int invalidationRatio;
+    uint64_t sharedStart;
+
+    std::vector<cacheSetMgr> cacheMgr;
+
+    uint64_t getTag(uint64_t addr) const;
+    uint64_t getSet(uint64_t addr) const;
+    bool isFullBlock(uint64_t addr, int size) const;
+    bool isHit(uint64_t addr, int &lineID);
+    CacheLine &lineAt(uint64_t addr, int lineID);
+    int allocate(uint64_t addr);
+    void evict(uint64_t addr);
+    void flush();
+
+    // hooks for the adaptive protocol's bookkeeping
+    virtual void onAllocate(uint64_t addr, CacheLine &line) {}
+    virtual void onEvict(uint64_t addr, CacheLine &line) {}
+};
+
+class MesiModel : public ModelCache {
+public:
+    enum MesiState { Invalid, Modified, Shared, Exclusive };
+
+    using ModelCache::ModelCache;
+
+    AccessResult access(uint64_t addr, int size, bool isWrite) override;
+    void snoop(uint64_t addr, bool isWrite, BusOperationType op) override;
+};
+
+// Dragon, Hybrid and Adapt share the same five states
+enum UpdateState {
+    INVALID = 0,
+    EXCLUSIVE = 1,
+    MODIFIED = 2,
+    SHARED_CLEAN = 3,
+    SHARED_MOD = 4
+};
+
+class DragonModel : public ModelCache {
+public:
+    using ModelCache::ModelCache;
+
+    AccessResult access(uint64_t addr, int size, bool isWrite) override;
+    void snoop(uint64_t addr, bool isWrite, BusOperationType op) override;
+};
+
+class HybridModel : public ModelCache {
+public:
+    HybridModel(int cacheId, const ModelParams &params, ModelBus &bus,
+                bool adaptive);
+
+    AccessResult access(uint64_t addr, int size, bool isWrite) override;
+    void snoop(uint64_t addr, bool isWrite, BusOperationType op) override;
+
+protected:
+    // Adapt learns a threshold per block, Hybrid uses a fixed one
+    bool adaptive;
+
+    uint64_t getBlkNumber(uint64_t addr) const;
+    int blockThreshold(uint64_t addr) const;
+    void endWriteRun(uint64_t addr, int &currWriteRun);
+
+    void onAllocate(uint64_t addr, CacheLine &line) override;
+    void onEvict(uint64_t addr, CacheLine &line) override;
+};
+
+std::unique_ptr<ModelCache> makeCache(Protocol protocol, int cacheId,
+                                      const ModelParams &params,
+                                      ModelBus &bus);
+
+}
@@ -0,0 +1,199 @@
+#include "trace_replay.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace tracesim {
+
+// layout written by gem5::CoherenceTrace, see cc/src/coherence_trace.hh
+static const char traceMagic[8] = {'C', 'C', 'T', 'R', 'A', 'C', 'E', '\0'};
+
+#pragma pack(push, 1)
+typedef struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+} TraceHeader;
+#pragma pack(pop)
+
+typedef struct TraceRecord {
+    uint64_t tick;
+    uint64_t addr;
+    int16_t cacheId;
+    uint8_t op;
+    uint8_t fromState;
+    uint8_t toState;
+    uint8_t source;
+    uint16_t bytes;
+} TraceRecord;
+
+static_assert(sizeof(TraceHeader) == 16, "trace header layout");
+static_assert(sizeof(TraceRecord) == 24, "trace record layout");
+
+static const uint8_t TracePrRd = 4;
+static const uint8_t TracePrWr = 5;
+static const uint8_t TraceFromCache = 0;
+
+static bool loadBinaryTrace(FILE *file, const std::string &path,
+                            std::vector<TraceAccess> &accesses,
+                            std::string &err) {
+    TraceHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.recordSize != sizeof(TraceRecord)) {
+        err = path + ": unsupported coherence trace layout";
+        return false;
+    }
+
+    std::vector<TraceRecord> chunk(65536);
+    size_t n;
+    while ((n = fread(chunk.data(), sizeof(TraceRecord), chunk.size(),
+                      file)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const TraceRecord &rec = chunk[i];
+            // only the cpu side of a cache trace drives the replay
+            if (rec.source != TraceFromCache ||
+                (rec.op != TracePrRd && rec.op != TracePrWr)) {
+                continue;
+            }
+            accesses.push_back({rec.tick, rec.addr, rec.cacheId, rec.bytes,
+                                rec.op == TracePrWr});
+        }
+    }
+    return true;
+}
+
+static bool loadTextTrace(const std::string &path,
+                          std::vector<TraceAccess> &accesses,
+                          std::string &err) {
+    std::ifstream in(path);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        TraceAccess access;
+        std::string type;
+        fields >> access.tick >> access.core >> type;
+        fields >> std::hex >> access.addr >> std::dec >> access.size;
+        if (fields.fail() || (type != "R" && type != "W")) {
+            err = path + ":" + std::to_string(lineNo) +
+                  ": expected <tick> <core> <R|W> <addr> <size>";
+            return false;
+        }
+        access.isWrite = (type == "W");
+        accesses.push_back(access);
+    }
+    return true;
+}
+
+bool loadTrace(const std::string &path, std::vector<TraceAccess> &accesses,
+               std::string &err) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        err = path + ": " + strerror(errno);
+        return false;
+    }
+
+    char magic[sizeof(traceMagic)];
+    bool binary = fread(magic, sizeof(magic), 1, file) == 1 &&
+                  memcmp(magic, traceMagic, sizeof(magic)) == 0;
+    bool ok;
+    if (binary) {
+        rewind(file);
+        ok = loadBinaryTrace(file, path, accesses, err);
+        fclose(file);
+    }
+    else {
+        fclose(file);
+        ok = loadTextTrace(path, accesses, err);
+    }
+    return ok;
+}
+
+size_t prepareTrace(std::vector<TraceAccess> &accesses,
+                    const ModelParams &params) {
+    size_t before = accesses.size();
+    accesses.erase(std::remove_if(accesses.begin(), accesses.end(),
+                                  [&](const TraceAccess &a) {
+                                      return a.addr < params.sharedStart ||
+                                             a.addr >= params.sharedEnd ||
+                                             a.core < 0;
+                                  }),
+                   accesses.end());
+    std::stable_sort(accesses.begin(), accesses.end(),
+                     [](const TraceAccess &a, const TraceAccess &b) {
+                         return a.tick < b.tick;
+                     });
+    return before - accesses.size();
+}
+
+ReplayResult replay(Protocol protocol, const ModelParams &params,
+                    const ReplayTiming &timing,
+                    const std::vector<TraceAccess> &accesses) {
+    ReplayResult result;
+    result.protocol = protocol;
+    for (const TraceAccess &access : accesses) {
+        result.numCores = std::max(result.numCores, access.core + 1);
+    }
+
+    ModelBus bus;
+    for (int i = 0; i < result.numCores; i++) {
+        bus.caches.push_back(makeCache(protocol, i, params, bus));
+    }
+    result.coreCycles.assign(result.numCores, 0);
+
+    // the bus is serializing, one transaction at a time
+    uint64_t busFree = 0;
+    for (const TraceAccess &access : accesses) {
+        ModelCache &cache = *bus.caches[access.core];
+        int fromState = cache.getCohState(access.addr);
+        AccessResult res = cache.access(access.addr, access.size,
+                                        access.isWrite);
+        if (cache.getCohState(access.addr) != fromState) {
+            cache.stats.prTransitions++;
+        }
+
+        uint64_t &now = result.coreCycles[access.core];
+        if (!res.usedBus) {
+            now += timing.hitLatency;
+        }
+        else {
+            uint64_t occupancy = timing.busLatency +
+                                 (res.memFetch ? timing.memLatency : 0);
+            uint64_t start = std::max(now, busFree);
+            busFree = start + occupancy;
+            result.busBusyCycles += occupancy;
+            now = busFree;
+        }
+
+        result.accesses++;
+        if (access.isWrite) {
+            result.writes++;
+        }
+        else {
+            result.reads++;
+        }
+        if (res.memFetch) {
+            result.memFetches++;
+        }
+    }
+
+    for (auto &cache : bus.caches) {
+        result.caches.push_back(cache->stats);
+    }
+    result.bus = bus.stats;
+    for (uint64_t c : result.coreCycles) {
+        result.cycles = std::max(result.cycles, c);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Per-core access traces and their replay through a protocol model.
+
+#include "coherence_model.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tracesim {
+
+typedef struct TraceAccess {
+    uint64_t tick;
+    uint64_t addr;
+    int core;
+    int size;
+    bool isWrite;
+} TraceAccess;
+
+// Appends the cpu accesses of one trace file. Both the binary .cctrace
+// written by a CoherentCacheBase (its PrRd/PrWr records) and a text format
+// of "<tick> <core> <R|W> <addr> <size>" lines are accepted. Returns false
+// with a message in err if the file cannot be read.
+bool loadTrace(const std::string &path, std::vector<TraceAccess> &accesses,
+               std::string &err);
+
+// Orders accesses by tick, keeping file order for equal ticks, and drops
+// the ones outside [sharedStart, sharedEnd). Returns the number dropped.
+size_t prepareTrace(std::vector<TraceAccess> &accesses,
+                    const ModelParams &params);
+
+// Simple timing: cores issue back to back, a hit costs hitLatency, a bus
+// transaction waits for the bus and holds it for busLatency, plus
+// memLatency when the block has to come from memory.
+typedef struct ReplayTiming {
+    uint64_t hitLatency = 1;
+    uint64_t busLatency = 2;
+    uint64_t memLatency = 100;
+} ReplayTiming;
+
+typedef struct ReplayResult {
+    Protocol protocol;
+    int numCores = 0;
+    uint64_t accesses = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t memFetches = 0;
+    BusStats bus;
+    std::vector<CacheStats> caches;
+    std::vector<uint64_t> coreCycles;
+    uint64_t cycles = 0;
+    uint64_t busBusyCycles = 0;
+} ReplayResult;
+
+ReplayResult replay(Protocol protocol, const ModelParams &params,
+                    const ReplayTiming &timing,
+                    const std::vector<TraceAccess> &accesses);
+
+}
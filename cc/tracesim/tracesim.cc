@@ -0,0 +1,245 @@
+// Trace-driven coherence simulator. Replays per-core access traces captured
+// from gem5 (or written by hand) through models of one or more protocols and
+// prints the same bus statistics SerializingBus reports, one column per
+// protocol. Every protocol gets its own caches and bus and runs on its own
+// thread over the same access order, so the columns are directly comparable.
+//
+//   g++ -O2 -std=c++17 -pthread -o tracesim cc/tracesim/*.cc
+//   ./tracesim --protocol all --invalidation-ratio 3 m5out/*.cctrace
+
+#include "trace_replay.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tracesim;
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s [options] trace...\n"
+        "  --protocol LIST             comma separated mesi, dragon, hybrid,\n"
+        "                              adapt, or all (default mesi)\n"
+        "  --block-offset N            log2 block size (default 5)\n"
+        "  --set-bit N                 log2 number of sets (default 4)\n"
+        "  --cache-size-bit N          log2 cache size (default 15)\n"
+        "  --invalid-threshold N       hybrid/adapt initial threshold "
+        "(default 5 hybrid, 0 adapt)\n"
+        "  --invalidation-ratio N      adapt write run ratio (default 2)\n"
+        "  --shared-start ADDR         first cacheable address "
+        "(default 0x8000)\n"
+        "  --shared-end ADDR           end of cacheable range "
+        "(default 0xa000)\n"
+        "  --hit-latency N             cycles per cache hit (default 1)\n"
+        "  --bus-latency N             cycles per bus transaction "
+        "(default 2)\n"
+        "  --mem-latency N             cycles per memory fetch "
+        "(default 100)\n"
+        "traces are gem5 .cctrace files of the caches or text files of\n"
+        "\"<tick> <core> <R|W> <addr> <size>\" lines\n", prog);
+    exit(1);
+}
+
+typedef struct ReportRow {
+    const char *name;
+    std::function<std::string(const ReplayResult &)> value;
+} ReportRow;
+
+static std::string count(uint64_t val) {
+    return std::to_string(val);
+}
+
+static std::string ratio(uint64_t num, uint64_t den) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.4f", den ? (double)num / den : 0.0);
+    return buf;
+}
+
+static uint64_t sumCaches(const ReplayResult &r,
+                          uint64_t CacheStats::*field) {
+    uint64_t total = 0;
+    for (const CacheStats &c : r.caches) {
+        total += c.*field;
+    }
+    return total;
+}
+
+// one column per protocol, one row per statistic
+static void printReport(const std::vector<ReplayResult> &results) {
+    std::vector<ReportRow> rows = {
+        {"protocol", [](const ReplayResult &r) {
+            return std::string(protocolName(r.protocol)); }},
+        {"cores", [](const ReplayResult &r) { return count(r.numCores); }},
+        {"accesses", [](const ReplayResult &r) { return count(r.accesses); }},
+        {"reads", [](const ReplayResult &r) { return count(r.reads); }},
+        {"writes", [](const ReplayResult &r) { return count(r.writes); }},
+        {"hits", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::hitCount)); }},
+        {"misses", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::missCount)); }},
+        {"missRate", [](const ReplayResult &r) {
+            return ratio(sumCaches(r, &CacheStats::missCount), r.accesses); }},
+        {"transCount", [](const ReplayResult &r) {
+            return count(r.bus.transCount); }},
+        {"rdxCount", [](const ReplayResult &r) {
+            return count(r.bus.rdxCount); }},
+        {"rdCount", [](const ReplayResult &r) {
+            return count(r.bus.rdCount); }},
+        {"updCount", [](const ReplayResult &r) {
+            return count(r.bus.updCount); }},
+        {"rdBytes", [](const ReplayResult &r) {
+            return count(r.bus.rdBytes); }},
+        {"updBytes", [](const ReplayResult &r) {
+            return count(r.bus.updBytes); }},
+        {"writebacks", [](const ReplayResult &r) {
+            return count(r.bus.writebacks); }},
+        {"memFetches", [](const ReplayResult &r) {
+            return count(r.memFetches); }},
+        {"prTransitions", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::prTransitions)); }},
+        {"snoopTransitions", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::snoopTransitions)); }},
+        {"invalidations", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::invalidations)); }},
+        {"evictions", [](const ReplayResult &r) {
+            return count(sumCaches(r, &CacheStats::evictions)); }},
+        {"cycles", [](const ReplayResult &r) { return count(r.cycles); }},
+        {"busUtilization", [](const ReplayResult &r) {
+            return ratio(r.busBusyCycles, r.cycles); }},
+    };
+
+    for (const ReportRow &row : rows) {
+        printf("%-24s", row.name);
+        for (const ReplayResult &r : results) {
+            printf(" %14s", row.value(r).c_str());
+        }
+        printf("\n");
+    }
+}
+
+static bool parseProtocolList(const std::string &list,
+                              std::vector<Protocol> &protocols) {
+    if (list == "all") {
+        protocols = {Protocol::Mesi, Protocol::Dragon, Protocol::Hybrid,
+                     Protocol::Adapt};
+        return true;
+    }
+    protocols.clear();
+    std::istringstream names(list);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        Protocol protocol;
+        if (!parseProtocol(name, protocol)) {
+            fprintf(stderr, "unknown protocol %s\n", name.c_str());
+            return false;
+        }
+        protocols.push_back(protocol);
+    }
+    return !protocols.empty();
+}
+
+int main(int argc, char **argv) {
+    std::vector<Protocol> protocols = {Protocol::Mesi};
+    ModelParams params;
+    ReplayTiming timing;
+    bool thresholdSet = false;
+    std::vector<std::string> traces;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            traces.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+        }
+        const char *val = argv[++i];
+        if (arg == "--protocol") {
+            if (!parseProtocolList(val, protocols)) {
+                usage(argv[0]);
+            }
+        }
+        else if (arg == "--block-offset") {
+            params.blockOffset = atoi(val);
+        }
+        else if (arg == "--set-bit") {
+            params.setBit = atoi(val);
+        }
+        else if (arg == "--cache-size-bit") {
+            params.cacheSizeBit = atoi(val);
+        }
+        else if (arg == "--invalid-threshold") {
+            params.invalidThreshold = atoi(val);
+            thresholdSet = true;
+        }
+        else if (arg == "--invalidation-ratio") {
+            params.invalidationRatio = atoi(val);
+        }
+        else if (arg == "--shared-start") {
+            params.sharedStart = strtoull(val, nullptr, 0);
+        }
+        else if (arg == "--shared-end") {
+            params.sharedEnd = strtoull(val, nullptr, 0);
+        }
+        else if (arg == "--hit-latency") {
+            timing.hitLatency = strtoull(val, nullptr, 0);
+        }
+        else if (arg == "--bus-latency") {
+            timing.busLatency = strtoull(val, nullptr, 0);
+        }
+        else if (arg == "--mem-latency") {
+            timing.memLatency = strtoull(val, nullptr, 0);
+        }
+        else {
+            usage(argv[0]);
+        }
+    }
+    if (traces.empty()) {
+        usage(argv[0]);
+    }
+    if (params.cacheSizeBit < params.setBit + params.blockOffset ||
+        params.sharedEnd <= params.sharedStart) {
+        fprintf(stderr, "cache geometry or cacheable range is empty\n");
+        return 1;
+    }
+    std::vector<TraceAccess> accesses;
+    for (const std::string &path : traces) {
+        std::string err;
+        if (!loadTrace(path, accesses, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+    size_t dropped = prepareTrace(accesses, params);
+    if (dropped) {
+        fprintf(stderr, "ignored %zu accesses outside the cacheable range\n",
+                dropped);
+    }
+
+    // the trace is only read, each worker owns its caches, bus and result
+    std::vector<ReplayResult> results(protocols.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < protocols.size(); i++) {
+        ModelParams protoParams = params;
+        // same defaults as HybridCache and AdaptCache in CoherentCache.py
+        if (!thresholdSet) {
+            protoParams.invalidThreshold =
+                protocols[i] == Protocol::Adapt ? 0 : 5;
+        }
+        workers.emplace_back([&, i, protoParams]() {
+            results[i] = replay(protocols[i], protoParams, timing, accesses);
+        });
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    printReport(results);
+    return 0;
+}
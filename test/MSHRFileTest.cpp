@@ -0,0 +1,139 @@
+// Standalone checks of MSHRFile's open-addressed table, no Ramulator build
+// needed:
+//   g++ -std=c++11 -I. -o mshr_test test/MSHRFileTest.cpp MSHRFile.cpp
+//   ./mshr_test
+#undef NDEBUG
+
+#include "MSHRFile.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace ramulator;
+
+namespace {
+
+const int block_size = 64;
+
+// the first n blocks from start on whose home is the given table index
+std::vector<long> blocks_at(const MSHRFile& mshr, unsigned long home,
+                            int n, long start = 0) {
+  std::vector<long> blocks;
+  for (long b = start; int(blocks.size()) < n; b++) {
+    if (mshr.hash(b) == home) {
+      blocks.push_back(b);
+    }
+  }
+  return blocks;
+}
+
+long addr_of(long block) { return block * block_size; }
+
+// every entry is found where it is, and the table holds exactly them
+void check(const MSHRFile& mshr, const std::map<long, int>& live) {
+  for (auto& entry : live) {
+    assert(mshr.find(addr_of(entry.first)) == entry.second);
+  }
+  size_t used = 0;
+  for (int slot : mshr.table) {
+    used += slot != -1;
+  }
+  assert(used == live.size());
+  assert(mshr.size() == live.size());
+}
+
+void test_wrap_around() {
+  MSHRFile mshr(8, block_size);
+  unsigned long last = mshr.table_mask;
+
+  // a probe run starting at the last index wraps to the front of the
+  // table, and a block homed at index 0 has to go behind it
+  std::vector<long> tail = blocks_at(mshr, last, 3);
+  std::vector<long> front = blocks_at(mshr, 0, 1);
+
+  std::map<long, int> live;
+  for (long b : tail) {
+    live[b] = mshr.allocate(addr_of(b), 0, 0);
+  }
+  live[front[0]] = mshr.allocate(addr_of(front[0]), 0, 0);
+  assert(mshr.table[last] == live[tail[0]]);
+  assert(mshr.table[0] == live[tail[1]]);
+  assert(mshr.table[1] == live[tail[2]]);
+  assert(mshr.table[2] == live[front[0]]);
+  check(mshr, live);
+
+  // releasing the head of the run shifts the rest back across the wrap
+  mshr.release(live[tail[0]]);
+  live.erase(tail[0]);
+  assert(mshr.table[last] == live[tail[1]]);
+  assert(mshr.table[0] == live[tail[2]]);
+  assert(mshr.table[1] == live[front[0]]);
+  assert(mshr.table[2] == -1);
+  check(mshr, live);
+
+  // a block at its home position stays there
+  mshr.release(live[tail[1]]);
+  live.erase(tail[1]);
+  assert(mshr.table[last] == live[tail[2]]);
+  assert(mshr.table[0] == live[front[0]]);
+  check(mshr, live);
+
+  mshr.release(live[tail[2]]);
+  live.erase(tail[2]);
+  assert(mshr.table[last] == -1);
+  assert(mshr.table[0] == live[front[0]]);
+  check(mshr, live);
+}
+
+void test_full() {
+  MSHRFile mshr(4, block_size);
+  for (long b = 0; b < 4; b++) {
+    assert(mshr.allocate(addr_of(b), int(b), int(b) % 2) != -1);
+  }
+  assert(mshr.full());
+  assert(mshr.allocate(addr_of(4), 4, 0) == -1);
+
+  // any byte of the block finds its entry
+  int slot = mshr.find(addr_of(2) + block_size - 1);
+  assert(slot != -1 && mshr[slot].line == 2 && mshr[slot].coreid == 0);
+  mshr.release(slot);
+  assert(!mshr.full());
+  assert(mshr.find(addr_of(2)) == -1);
+}
+
+// random allocations and releases over few blocks, so probe runs collide
+// and wrap, checked against a map
+void test_random() {
+  srand(1);
+  MSHRFile mshr(16, block_size);
+  std::map<long, int> live;
+  for (int i = 0; i < 200000; i++) {
+    long b = rand() % 64;
+    auto it = live.find(b);
+    if (it != live.end()) {
+      mshr.release(it->second);
+      live.erase(it);
+    } else if (!mshr.full()) {
+      live[b] = mshr.allocate(addr_of(b), 0, 0);
+    }
+    if (i % 16 == 0) {
+      check(mshr, live);
+      for (long other = 64; other < 72; other++) {
+        assert(mshr.find(addr_of(other)) == -1);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_wrap_around();
+  test_full();
+  test_random();
+  printf("MSHRFile tests passed\n");
+  return 0;
+}
@@ -0,0 +1,146 @@
+// Standalone checks of TimingWheel ordering, no Ramulator build needed:
+//   g++ -std=c++11 -I. -o timing_wheel_test test/TimingWheelTest.cpp
+//   ./timing_wheel_test
+#undef NDEBUG
+
+#include "TimingWheel.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace ramulator;
+
+namespace {
+
+// (cycle the item was handed out at, item)
+typedef std::vector<std::pair<long, int>> Trace;
+
+void expire_into(TimingWheel<int>& wheel, long now, Trace& out) {
+  wheel.expire(now,
+               [&](int item) { out.push_back(std::make_pair(now, item)); });
+}
+
+void test_same_cycle() {
+  TimingWheel<int> wheel(8);
+  // pushed out of cycle order, same-cycle items keep their push order
+  wheel.push(3, 1);
+  wheel.push(2, 2);
+  wheel.push(3, 3);
+  wheel.push(2, 4);
+  wheel.push(3, 5);
+  assert(wheel.size() == 5);
+
+  Trace out;
+  expire_into(wheel, 1, out);
+  assert(out.empty());
+  expire_into(wheel, 3, out);
+  int expected[] = {2, 4, 1, 3, 5};
+  assert(out.size() == 5);
+  for (int i = 0; i < 5; i++) {
+    assert(out[i].second == expected[i]);
+  }
+  assert(wheel.empty());
+}
+
+void test_overflow() {
+  TimingWheel<int> wheel(8);
+  wheel.expire(0, [](int) { assert(false); });
+
+  // 20 is beyond the 8 slots and waits in the overflow map, the later
+  // pushes for it land in its slot once the wheel has caught up
+  wheel.push(20, 1);
+  wheel.push(100, 2);
+  wheel.push(20, 3);
+  wheel.push(9, 4);
+  Trace out;
+  expire_into(wheel, 15, out);
+  assert(out.size() == 1 && out[0].second == 4);
+
+  wheel.push(20, 5);
+  wheel.push(20, 6);
+  wheel.push(16, 7);
+  out.clear();
+  expire_into(wheel, 20, out);
+  int expected[] = {7, 1, 3, 5, 6};
+  assert(out.size() == 5);
+  for (int i = 0; i < 5; i++) {
+    assert(out[i].second == expected[i]);
+  }
+  assert(out[0].first == 20 && wheel.size() == 1);
+
+  // a slot reused after wrapping around only holds its new cycle's items
+  wheel.push(28, 8);
+  out.clear();
+  expire_into(wheel, 99, out);
+  assert(out.size() == 1 && out[0].second == 8);
+  expire_into(wheel, 100, out);
+  assert(out.size() == 2 && out[1].second == 2);
+  assert(wheel.empty());
+}
+
+void test_late() {
+  TimingWheel<int> wheel(8);
+  wheel.push(5, 1);
+  Trace out;
+  // f pushes for a cycle already expired, the next call hands it out first
+  wheel.expire(5, [&](int item) {
+    out.push_back(std::make_pair(5L, item));
+    wheel.push(4, 2);
+    wheel.push(5, 3);
+    wheel.push(6, 4);
+  });
+  assert(out.size() == 1 && wheel.size() == 3);
+  wheel.push(6, 5);
+  expire_into(wheel, 6, out);
+  int expected[] = {1, 2, 3, 4, 5};
+  assert(out.size() == 5);
+  for (int i = 0; i < 5; i++) {
+    assert(out[i].second == expected[i]);
+  }
+  assert(wheel.empty());
+}
+
+// random pushes up to well past the slots, checked against a multimap
+// that hands out by cycle and then push order
+void test_random() {
+  srand(1);
+  TimingWheel<int> wheel(16);
+  std::multimap<long, int> ref;
+  long now = 0;
+  int next = 0;
+  for (int step = 0; step < 20000; step++) {
+    int pushes = rand() % 4;
+    for (int i = 0; i < pushes; i++) {
+      long when = now + 1 + rand() % 40;
+      wheel.push(when, next);
+      ref.emplace(when, next);
+      next++;
+    }
+    now += 1 + rand() % 3;
+    Trace out;
+    expire_into(wheel, now, out);
+    auto end = ref.upper_bound(now);
+    size_t due = 0;
+    for (auto it = ref.begin(); it != end; ++it, ++due) {
+      assert(due < out.size() && out[due].second == it->second);
+    }
+    assert(due == out.size());
+    ref.erase(ref.begin(), end);
+    assert(wheel.size() == ref.size());
+  }
+}
+
+}  // namespace
+
+int main() {
+  test_same_cycle();
+  test_overflow();
+  test_late();
+  test_random();
+  printf("TimingWheel tests passed\n");
+  return 0;
+}